@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+* @brief Правило закрепления потоков параллельного умножения за логическими ядрами.
+*/
+enum class AffinityPolicy {
+    None,       ///< не закреплять, потоки размещает ОС
+    Compact,    ///< подряд идущие ядра, сначала заполняется узел NUMA 0
+    Spread,     ///< потоки по очереди на разных узлах NUMA, внутри узла - равномерно по его ядрам
+    Explicit    ///< поток i - на ядре cpus[i % cpus.size()]
+};
+
+/**
+* @brief Настройки размещения: закрепление потоков и размещение страниц матриц по узлам NUMA.
+*/
+struct AffinityConfig {
+    AffinityPolicy policy = AffinityPolicy::None;
+    std::vector<int> cpus;          ///< ядра для Explicit
+    bool numaPlacement = false;     ///< B - чередованием по узлам, панели строк A и C - на узле потока-владельца
+};
+
+/**
+* @brief Узлы NUMA и их логические ядра, доступные процессу. Если ОС не сообщает топологию,
+* все доступные ядра считаются одним узлом.
+*/
+struct NumaTopology {
+    std::vector<int> nodeIds;               ///< номера узлов в ОС
+    std::vector<std::vector<int>> nodeCpus; ///< ядра каждого узла по возрастанию
+
+    int nodes() const { return static_cast<int>(nodeIds.size()); }
+    /// @brief Номер узла (в ОС), к которому относится ядро, -1 если неизвестно
+    int nodeOf(int cpu) const;
+
+    /// @brief Топология машины (определяется один раз)
+    static const NumaTopology& system();
+};
+
+/**
+* @brief Разбор правила из строки: none, compact, spread или список ядер через запятую (Explicit).
+* @throw std::invalid_argument если строка не распознана
+*/
+AffinityConfig parseAffinity(const std::string& value);
+
+/// @brief Название правила: none, compact, spread или список ядер
+std::string affinityName(const AffinityConfig& config);
+
+/**
+* @brief Ядро для каждого из threads потоков по правилу; для None - пустой список.
+* @throw std::invalid_argument если для Explicit список пуст или ядро недоступно процессу
+*/
+std::vector<int> affinityPlan(const AffinityConfig& config, int threads);
+
+/// @brief Закрепление вызывающего потока за ядром cpu (cpu < 0 - ничего не делает)
+void pinCurrentThread(int cpu);
+
+/// @brief Ядра, на которых разрешено выполняться вызывающему потоку (на Windows - процессу)
+std::vector<int> currentThreadCpus();
+
+/**
+* @brief Набор ядер вызывающего потока, сохранённый до его закрепления и восстанавливаемый
+* в деструкторе (в том же потоке). Пустой объект ничего не восстанавливает.
+*/
+class SavedAffinity {
+public:
+    SavedAffinity() = default;
+    SavedAffinity(SavedAffinity&& other) noexcept;
+    SavedAffinity& operator=(SavedAffinity&& other) noexcept;
+    SavedAffinity(const SavedAffinity&) = delete;
+    SavedAffinity& operator=(const SavedAffinity&) = delete;
+    ~SavedAffinity();
+
+    /// @brief Сохранение текущего набора ядер вызывающего потока
+    static SavedAffinity capture();
+
+private:
+    std::vector<int> cpus;
+    bool saved = false;
+
+    void restore();
+};
+
+/// @brief Номер узла NUMA, на котором выполняется вызывающий поток, -1 если неизвестен
+int currentNumaNode();
+
+/**
+* @brief Чередование страниц диапазона памяти по всем узлам NUMA (уже размещённые страницы
+* переносятся). Затрагиваются только страницы, целиком лежащие в диапазоне. Только Linux;
+* на одном узле ничего не делает.
+* @return false, если ОС не поддерживает или отказала
+*/
+bool interleaveMemory(void* data, std::size_t bytes);
+
+/**
+* @brief Размещение страниц диапазона памяти на узле node (предпочтительно, с переносом уже
+* размещённых страниц). Затрагиваются только страницы, целиком лежащие в диапазоне. Только
+* Linux; на одном узле ничего не делает.
+* @return false, если ОС не поддерживает или отказала
+*/
+bool placeMemoryOnNode(void* data, std::size_t bytes, int node);
@@ -0,0 +1,83 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "MatrixStorage.h"
+#include "ThreadPool.h"
+
+/**
+* @brief Результат асинхронного умножения. Операнды возвращаются вместе с C, чтобы их буферы
+* можно было заполнить следующими входными данными без нового выделения памяти.
+*/
+struct MultiplyResult {
+    AlignedMatrix<int> C;
+    AlignedMatrix<int> A;
+    AlignedMatrix<int> B;
+    double seconds = 0;         ///< время умножения
+    double queueSeconds = 0;    ///< время ожидания в очереди от submit до начала умножения
+};
+
+/**
+* @brief Очередь асинхронных умножений C = A * B.
+*
+* submit забирает операнды и сразу возвращает std::future, поэтому вызывающий поток может
+* загружать следующие операнды, пока текущие умножаются. Запросы выполняются в порядке поступления
+* не более чем concurrency одновременно: постоянные потоки-диспетчеры очереди выполняют каждое
+* произведение на общем пуле ThreadPool::shared() не более чем threadsPerProduct потоками (gemmKernel
+* с планировкой steal), так что независимые произведения делят ядра пула и не создают
+* по команде OpenMP на запрос. При заполненной очереди (capacity ожидающих запросов) submit
+* ждёт, пока освободится место, и этим ограничивает память под ещё не обработанные операнды.
+*/
+class MultiplyQueue {
+public:
+    /**
+    * @param concurrency - наибольшее число одновременно выполняемых произведений
+    * @param threadsPerProduct - потоков пула на одно произведение, 0 - поровну между concurrency
+    * @param capacity - наибольшее число ожидающих запросов, 0 - без ограничения
+    * @throw std::invalid_argument если concurrency <= 0, threadsPerProduct < 0 или capacity < 0
+    */
+    explicit MultiplyQueue(int concurrency = 2, int threadsPerProduct = 0, int capacity = 0);
+    MultiplyQueue(const MultiplyQueue&) = delete;
+    MultiplyQueue& operator=(const MultiplyQueue&) = delete;
+
+    /// @brief Дожидается выполнения всех принятых запросов
+    ~MultiplyQueue();
+
+    /**
+    * @brief Постановка умножения в очередь. Исключение из умножения передаётся через future.
+    * @throw std::invalid_argument если число столбцов A не равно числу строк B
+    */
+    std::future<MultiplyResult> submit(AlignedMatrix<int> A, AlignedMatrix<int> B);
+
+    /// @brief Число принятых, но ещё не начатых запросов
+    int pending() const;
+
+    /// @brief Ожидание завершения всех принятых запросов
+    void wait();
+
+private:
+    struct Request {
+        AlignedMatrix<int> A;
+        AlignedMatrix<int> B;
+        std::promise<MultiplyResult> promise;
+        std::chrono::high_resolution_clock::time_point submitted;
+    };
+
+    int threadsPerProduct;
+    int capacity;
+    std::vector<std::thread> dispatchers;
+
+    mutable std::mutex mutex;
+    std::condition_variable ready;      ///< появился запрос или очередь останавливается
+    std::condition_variable space;      ///< освободилось место в очереди
+    std::condition_variable idle;       ///< все запросы выполнены
+    std::deque<Request> requests;
+    int running = 0;
+    bool stopping = false;
+
+    void run();
+};
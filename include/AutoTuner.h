@@ -0,0 +1,67 @@
+#pragma once
+#include <map>
+#include <mutex>
+#include <string>
+#include "Kernels.h"
+
+/**
+* @brief Конфигурация параллельного блочного умножения, выбранная автотюнером.
+*/
+struct TuningConfig {
+    int threads = 1;
+    BlockSizes tiles;
+    std::string schedule = "static";
+    int chunk = 0;              ///< порция блоков строк, 0 - по умолчанию OpenMP
+    double time = 0;            ///< лучшее время на пробной матрице, секунды
+};
+
+/**
+* @brief Автотюнер для multiplyAuto. При первом запросе для размера n перебирает потоки, размеры
+* блоков, планировку и порцию на пробной матрице и запоминает лучшую конфигурацию.
+*
+* Перебор покоординатный: потоки, затем блоки, затем планировка x порция, каждый раз при
+* лучших значениях остальных параметров. Победители хранятся по корзинам floor(log2 n) и
+* дописываются в файл кэша вместе с моделью процессора, поэтому следующий запуск программы
+* на той же машине настройку не повторяет. Записи других процессоров игнорируются.
+*/
+class AutoTuner {
+public:
+    /**
+    * @param cachePath - файл кэша настроек, пустая строка - хранить только в памяти
+    */
+    explicit AutoTuner(std::string cachePath);
+
+    /**
+    * @brief Общий для процесса автотюнер. Путь к кэшу берётся из переменной окружения
+    * MATRIX_TUNING_CACHE, по умолчанию matrix_tuning.cache в текущем каталоге.
+    */
+    static AutoTuner& instance();
+
+    /**
+    * @brief Лучшая известная конфигурация для размера n; при отсутствии выполняет настройку.
+    * Потокобезопасен.
+    *
+    * @throw std::invalid_argument если n <= 0
+    */
+    TuningConfig configFor(int n);
+
+    /// @brief Корзина размера в кэше: floor(log2 n)
+    static int bucketOf(int n);
+
+    /// @brief Сколько раз этот объект выполнял настройку (не брал результат из кэша)
+    int tuningRuns() const;
+
+    const std::string& cachePath() const;
+
+private:
+    TuningConfig tune(int n) const;
+    void load();
+    void store(int bucket, const TuningConfig& config) const;
+
+    std::string path;
+    std::string cpu;
+    std::map<int, TuningConfig> configs;
+    bool loaded = false;
+    int runs = 0;
+    mutable std::mutex mutex;
+};
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "MatrixStorage.h"
+
+/**
+* @brief Одно умножение пакета: C = A * B, A - m x k, B - k x n, C - m x n с шагом строки ldc.
+*/
+struct BatchEntry {
+    MatrixView<int> A;
+    MatrixView<int> B;
+    int* C;
+    std::ptrdiff_t ldc;
+};
+
+/**
+* @brief Пакет одинаковых умножений, расположенных в памяти с постоянным шагом:
+* i-е произведение - A + i * strideA, B + i * strideB, C + i * strideC.
+*/
+struct StridedBatch {
+    int count = 0;
+    int m = 0, n = 0, k = 0;
+    const int* A = nullptr;
+    std::ptrdiff_t lda = 0, strideA = 0;
+    const int* B = nullptr;
+    std::ptrdiff_t ldb = 0, strideB = 0;
+    int* C = nullptr;
+    std::ptrdiff_t ldc = 0, strideC = 0;
+};
+
+/**
+* @brief Умножение пакета небольших матриц. Параллелизм - по элементам пакета (одна команда
+* потоков на весь пакет, schedule(runtime)), каждое произведение считается одним потоком.
+* Для квадратных n = 4, 8, 16 используются ядра с размером, известным при компиляции, для прочих
+* произведений меньше 16^3 - общее ядро, для остальных (n от ~17) - последовательное блочное ядро
+* с SIMD-микроядром. Буферы упаковки выделяются каждым потоком один раз на пакет.
+*
+* @param num_threads - количество потоков
+* @param type - планировка распределения произведений: static, dynamic или guided
+* @param chunk - размер порции произведений, 0 - по умолчанию OpenMP
+* @throw std::invalid_argument если размеры какого-либо произведения не согласованы
+* (проверяется до начала вычислений) или планировка неверна
+*/
+void multiplyBatched(const std::vector<BatchEntry>& batch, int num_threads, const std::string& type = "static",
+    int chunk = 0);
+
+/**
+* @brief То же для пакета с постоянным шагом.
+*
+* @throw std::invalid_argument если размеры отрицательны или шаги строк меньше ширины матриц
+*/
+void multiplyStridedBatched(const StridedBatch& batch, int num_threads, const std::string& type = "static",
+    int chunk = 0);
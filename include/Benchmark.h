@@ -0,0 +1,102 @@
+#pragma once
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Matrix.h"
+
+/**
+* @brief Параметры серии замеров. Значения по умолчанию повторяют прежний перебор из main.cpp.
+*/
+struct BenchmarkConfig {
+    std::vector<int> sizes = { 500, 600, 800, 1000, 1200 };
+    std::vector<int> threads = { 1, 2, 4, 8 };
+    std::vector<std::string> schedules = { "static", "dynamic", "guided" };
+    std::vector<std::string> kernels = { "linear", "parallel", "blocked" };
+    std::vector<double> densities = { 1.0 };    ///< плотности B для сравнения разреженных и плотных путей
+    AffinityConfig affinity;    ///< закрепление потоков и размещение по узлам NUMA
+    bool perfCounters = false;  ///< собирать аппаратные счётчики (Matrix::enablePerfCounters)
+    int warmup = 1;             ///< прогревочных запусков перед замерами
+    int repetitions = 5;        ///< замеров на каждую конфигурацию
+    std::string csvPath;        ///< файл для CSV, пусто - не писать
+    std::string jsonPath;       ///< файл для JSON, пусто - не писать
+};
+
+/**
+* @brief Вариант умножения, доступный в переборе. Для вариантов без потоков или планировки
+* соответствующий параметр не перебирается.
+*/
+struct BenchmarkKernel {
+    std::string name;
+    bool usesThreads;
+    bool usesSchedule;
+    bool reportsTelemetry;      ///< заполняет Matrix::lastTelemetry()
+    std::function<double(Matrix&, int threads, const std::string& schedule)> run;
+};
+
+/**
+* @brief Статистика по замерам времени, секунды. p95 - по методу ближайшего ранга.
+*/
+struct SampleStats {
+    double min = 0;
+    double median = 0;
+    double p95 = 0;
+    double mean = 0;
+};
+
+/**
+* @brief Результат одной конфигурации (размер, плотность, вариант, планировка, потоки).
+*/
+struct BenchmarkResult {
+    int size = 0;
+    double density = 1.0;       ///< доля ненулевых элементов B
+    std::string kernel;
+    std::string schedule;       ///< "-" для вариантов без планировки
+    int threads = 1;
+    std::vector<double> samples;
+    SampleStats stats;
+    double gops = 0;            ///< 2*n^3 целочисленных операций / медианное время, млрд/с
+    double speedupLinear = 0;   ///< медиана linear того же размера и плотности / медиана, 0 если linear не измерялся
+    double speedupSingle = 0;   ///< медиана того же варианта на 1 потоке / медиана, 0 если не измерялась
+    double imbalance = 0;       ///< средний дисбаланс нагрузки потоков по телеметрии, 0 если её нет
+    PerfCounts counters;        ///< среднее за замер по сумме всех потоков, -1 если не собирались
+};
+
+/**
+* @brief Все варианты умножения, известные бенчмарку.
+*/
+const std::vector<BenchmarkKernel>& benchmarkKernels();
+
+/**
+* @brief Статистика по набору замеров.
+* @throw std::invalid_argument если замеров нет
+*/
+SampleStats computeStats(std::vector<double> samples);
+
+/**
+* @brief Разбор аргументов командной строки:
+* --sizes 500,1000 --threads 1,2,4 --schedules static,guided --kernels linear,blocked
+* --densities 1,0.1,0.01 --affinity compact|spread|0,2,4 --numa on --perf on --warmup 1 --reps 5
+* --csv out.csv --json out.json
+*
+* @throw std::invalid_argument при неизвестном аргументе, варианте, планировке или правиле закрепления
+*/
+BenchmarkConfig parseBenchmarkArgs(int argc, char** argv);
+
+/**
+* @brief Выполняет перебор конфигураций. Для каждой делается warmup прогревочных запусков
+* и repetitions замеров. При плотности меньше 1 матрица B заполняется с заданной долей ненулевых
+* элементов (фиксированный seed), A остаётся плотной.
+*
+* @param progress - поток для строк о ходе работы, nullptr - без вывода
+*/
+std::vector<BenchmarkResult> runBenchmark(const BenchmarkConfig& config, std::ostream* progress);
+
+/// @brief Запись результатов в CSV (одна строка на конфигурацию)
+void writeCsv(std::ostream& out, const std::vector<BenchmarkResult>& results);
+
+/// @brief Запись результатов в JSON вместе со сведениями о машине и сборке
+void writeJson(std::ostream& out, const std::vector<BenchmarkResult>& results);
+
+/// @brief Таблица результатов для человека; при собранных счётчиках - вторая таблица с ними
+void printTable(std::ostream& out, const std::vector<BenchmarkResult>& results);
@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "MatrixStorage.h"
+
+/**
+* @brief Порядок умножения цепочки A_1 * ... * A_m, где A_i имеет размер dims[i-1] x dims[i].
+* Выбирается динамическим программированием по размерам (минимум числа умножений элементов).
+*/
+struct ChainPlan {
+    std::vector<int> dims;                  ///< m + 1 размеров цепочки
+    std::vector<std::vector<int>> split;    ///< произведение A_i..A_j (с нуля) = (A_i..A_s)(A_s+1..A_j), s = split[i][j]
+    long long cost = 0;                     ///< сумма m * k * n по всем шагам
+
+    int length() const { return static_cast<int>(dims.size()) - 1; }
+
+    /// @brief Расстановка скобок, например ((A1(A2A3))A4)
+    std::string order() const;
+};
+
+/**
+* @brief Оптимальный порядок умножения цепочки за O(m^3) по размерам.
+* @throw std::invalid_argument если матриц нет или размер отрицателен
+*/
+ChainPlan planChain(const std::vector<int>& dims);
+
+/**
+* @brief Произведение цепочки в порядке planChain. Каждый шаг - параллельное блочное ядро
+* (gemmKernel). Промежуточные произведения пишутся в буферы, выделенные один раз до первого шага
+* и переиспользуемые по мере освобождения; для цепочки, умножаемой слева направо, их два
+* и шаги чередуют их. Последний шаг пишет сразу в результат.
+*
+* @throw std::invalid_argument если цепочка пуста или соседние размеры не согласованы
+*/
+AlignedMatrix<int> multiplyChain(const std::vector<MatrixView<int>>& chain, int num_threads);
+
+/**
+* @brief Степень квадратной матрицы A^exponent двоичным возведением (по битам показателя от
+* старшего: квадрат, затем умножение на A при единичном бите) - не больше 2 * log2(exponent)
+* умножений параллельным блочным ядром. Шаги чередуют два заранее выделенных буфера, A читается
+* на месте. A^0 - единичная матрица.
+*
+* @throw std::invalid_argument если A не квадратная или exponent < 0
+*/
+AlignedMatrix<int> matrixPower(MatrixView<int> A, int exponent, int num_threads);
@@ -0,0 +1,268 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "Kernels.h"
+#include "MatrixStorage.h"
+
+/**
+* @brief Ленивое произведение op(A) * op(B) - лист выражения. Операнды не копируются и должны
+* жить, пока выражение вычисляется; само произведение считается только в evaluate или свёртке.
+*/
+struct ProductExpr {
+    MatrixView<int> A;
+    MatrixView<int> B;
+    Transpose opA = Transpose::N;
+    Transpose opB = Transpose::N;
+
+    int rows() const { return opA == Transpose::N ? A.rows() : A.cols(); }
+    int cols() const { return opB == Transpose::N ? B.cols() : B.rows(); }
+    const ProductExpr& product() const { return *this; }
+    int apply(int, int, int value) const { return value; }
+};
+
+/**
+* @brief Узел выражения: поэлементная операция op над значением inner в (i, j).
+* Операции применяются к плитке произведения, пока она в кэше потока.
+*/
+template <class Inner, class Op>
+struct EpilogueExpr {
+    Inner inner;
+    Op op;
+
+    int rows() const { return inner.rows(); }
+    int cols() const { return inner.cols(); }
+    const ProductExpr& product() const { return inner.product(); }
+    int apply(int i, int j, int value) const { return op(i, j, inner.apply(i, j, value)); }
+};
+
+/// @brief Умножение на скаляр по модулю 2^32, как в ядрах умножения (без переполнения int)
+struct ScaleOp {
+    int alpha;
+    int operator()(int, int, int value) const {
+        return static_cast<int>(static_cast<unsigned>(alpha) * static_cast<unsigned>(value));
+    }
+};
+
+/// @brief Прибавление элемента матрицы D того же размера, что и выражение, по модулю 2^32
+struct AddOp {
+    MatrixView<int> D;
+    int operator()(int i, int j, int value) const {
+        return static_cast<int>(static_cast<unsigned>(value) + static_cast<unsigned>(D(i, j)));
+    }
+};
+
+/// @brief Ограничение значения отрезком [lo, hi]
+struct ClampOp {
+    int lo;
+    int hi;
+    int operator()(int, int, int value) const { return std::min(std::max(value, lo), hi); }
+};
+
+template <class T>
+struct IsExpression : std::false_type {};
+template <>
+struct IsExpression<ProductExpr> : std::true_type {};
+template <class Inner, class Op>
+struct IsExpression<EpilogueExpr<Inner, Op>> : std::true_type {};
+
+namespace expr_detail {
+
+template <class E>
+using EnableIfExpression = std::enable_if_t<IsExpression<E>::value, int>;
+
+// @throw std::invalid_argument если num_threads <= 0
+inline void checkThreads(const char* method, int num_threads) {
+    if (num_threads <= 0) {
+        throw std::invalid_argument(std::string(method) + ": количество потоков должно быть положительным");
+    }
+}
+
+// Элемент op(X)(i, j)
+inline int element(MatrixView<int> X, Transpose op, int i, int j) {
+    return op == Transpose::N ? X(i, j) : X(j, i);
+}
+
+// Элемент (i, i) произведения скалярным произведением строки op(A) и столбца op(B). Считается
+// по модулю 2^32, как в ядрах умножения, чтобы переполнение давало тот же элемент
+inline int diagonal(const ProductExpr& e, int i) {
+    const int k = e.opA == Transpose::N ? e.A.cols() : e.A.rows();
+    unsigned sum = 0;
+    for (int p = 0; p < k; p++) {
+        sum += static_cast<unsigned>(element(e.A, e.opA, i, p)) * static_cast<unsigned>(element(e.B, e.opB, p, i));
+    }
+    return static_cast<int>(sum);
+}
+
+} // namespace expr_detail
+
+/**
+* @brief Ленивое произведение op(A) * op(B).
+* @throw std::invalid_argument если внутренние размеры не совпадают
+*/
+ProductExpr product(MatrixView<int> A, MatrixView<int> B, Transpose opA = Transpose::N,
+    Transpose opB = Transpose::N);
+
+template <class E, expr_detail::EnableIfExpression<E> = 0>
+EpilogueExpr<E, ScaleOp> operator*(const E& e, int alpha) {
+    return { e, { alpha } };
+}
+
+template <class E, expr_detail::EnableIfExpression<E> = 0>
+EpilogueExpr<E, ScaleOp> operator*(int alpha, const E& e) {
+    return { e, { alpha } };
+}
+
+/// @throw std::invalid_argument если размер D не совпадает с размером выражения
+template <class E, expr_detail::EnableIfExpression<E> = 0>
+EpilogueExpr<E, AddOp> operator+(const E& e, MatrixView<int> D) {
+    if (D.rows() != e.rows() || D.cols() != e.cols()) {
+        throw std::invalid_argument("operator+: размер слагаемого не совпадает с размером выражения");
+    }
+    return { e, { D } };
+}
+
+/// @throw std::invalid_argument если lo > hi
+template <class E, expr_detail::EnableIfExpression<E> = 0>
+EpilogueExpr<E, ClampOp> clamp(const E& e, int lo, int hi) {
+    if (lo > hi) {
+        throw std::invalid_argument("clamp: нижняя граница больше верхней");
+    }
+    return { e, { lo, hi } };
+}
+
+/// @brief max(0, x) поэлементно
+template <class E, expr_detail::EnableIfExpression<E> = 0>
+EpilogueExpr<E, ClampOp> relu(const E& e) {
+    return { e, { 0, INT_MAX } };
+}
+
+/**
+* @brief Вычисление выражения в C (m x n, шаг ldc) за один проход: каждая плитка произведения
+* проходит все операции выражения в кэше и записывается в C один раз, C не читается.
+* C может совпадать со слагаемым D (C = A * B + C), но не должна пересекаться с A или B.
+* Все функции вычисления и свёртки выражений бросают std::invalid_argument при num_threads <= 0.
+*/
+template <class E, expr_detail::EnableIfExpression<E> = 0>
+void evaluate(const E& e, int* C, std::ptrdiff_t ldc, int num_threads, const BlockSizes& tiles = BlockSizes()) {
+    expr_detail::checkThreads("evaluate", num_threads);
+    const ProductExpr& p = e.product();
+    gemmTilesKernel(p.opA, p.opB, p.A, p.B, tiles, num_threads,
+        [&](int, int i0, int j0, int rows, int cols, const int* tile, std::ptrdiff_t ldt) {
+            for (int r = 0; r < rows; r++) {
+                const int* src = tile + r * ldt;
+                int* dst = C + (i0 + r) * ldc + j0;
+                const int i = i0 + r;
+                #pragma omp simd
+                for (int j = 0; j < cols; j++) {
+                    dst[j] = e.apply(i, j0 + j, src[j]);
+                }
+            }
+        });
+}
+
+/// @brief Вычисление выражения в новую матрицу
+template <class E, expr_detail::EnableIfExpression<E> = 0>
+AlignedMatrix<int> evaluate(const E& e, int num_threads, const BlockSizes& tiles = BlockSizes()) {
+    expr_detail::checkThreads("evaluate", num_threads);
+    AlignedMatrix<int> C = AlignedMatrix<int>::uninitialized(e.rows(), e.cols());
+    evaluate(e, C.data(), C.ld(), num_threads, tiles);
+    return C;
+}
+
+/**
+* @brief Суммы строк выражения. Все свёртки (rowSums, columnSums, sum, trace) складывают в
+* long long значения элементов в int - те же, что записал бы evaluate, включая переполнение int
+* при умножении. Плитки сворачиваются сразу после вычисления в частичные суммы потоков, C не
+* выделяется. Точные суммы произведения без переполнения - exactRowSums и др.
+*/
+template <class E, expr_detail::EnableIfExpression<E> = 0>
+std::vector<long long> rowSums(const E& e, int num_threads, const BlockSizes& tiles = BlockSizes()) {
+    expr_detail::checkThreads("rowSums", num_threads);
+    const ProductExpr& p = e.product();
+    std::vector<std::vector<long long>> partial(num_threads, std::vector<long long>(e.rows(), 0));
+    gemmTilesKernel(p.opA, p.opB, p.A, p.B, tiles, num_threads,
+        [&](int worker, int i0, int j0, int rows, int cols, const int* tile, std::ptrdiff_t ldt) {
+            for (int r = 0; r < rows; r++) {
+                const int* src = tile + r * ldt;
+                const int i = i0 + r;
+                long long sum = 0;
+                #pragma omp simd reduction(+ : sum)
+                for (int j = 0; j < cols; j++) {
+                    sum += e.apply(i, j0 + j, src[j]);
+                }
+                partial[worker][i] += sum;
+            }
+        });
+    for (int t = 1; t < num_threads; t++) {
+        for (int i = 0; i < e.rows(); i++) partial[0][i] += partial[t][i];
+    }
+    return std::move(partial[0]);
+}
+
+/// @brief Суммы столбцов выражения, устроены как rowSums
+template <class E, expr_detail::EnableIfExpression<E> = 0>
+std::vector<long long> columnSums(const E& e, int num_threads, const BlockSizes& tiles = BlockSizes()) {
+    expr_detail::checkThreads("columnSums", num_threads);
+    const ProductExpr& p = e.product();
+    std::vector<std::vector<long long>> partial(num_threads, std::vector<long long>(e.cols(), 0));
+    gemmTilesKernel(p.opA, p.opB, p.A, p.B, tiles, num_threads,
+        [&](int worker, int i0, int j0, int rows, int cols, const int* tile, std::ptrdiff_t ldt) {
+            long long* sums = partial[worker].data() + j0;
+            for (int r = 0; r < rows; r++) {
+                const int* src = tile + r * ldt;
+                const int i = i0 + r;
+                #pragma omp simd
+                for (int j = 0; j < cols; j++) {
+                    sums[j] += e.apply(i, j0 + j, src[j]);
+                }
+            }
+        });
+    for (int t = 1; t < num_threads; t++) {
+        for (int j = 0; j < e.cols(); j++) partial[0][j] += partial[t][j];
+    }
+    return std::move(partial[0]);
+}
+
+/// @brief Сумма всех элементов выражения, устроена как rowSums
+template <class E, expr_detail::EnableIfExpression<E> = 0>
+long long sum(const E& e, int num_threads, const BlockSizes& tiles = BlockSizes()) {
+    expr_detail::checkThreads("sum", num_threads);
+    long long total = 0;
+    for (long long value : rowSums(e, num_threads, tiles)) total += value;
+    return total;
+}
+
+/**
+* @brief Точные суммы строк, столбцов и всех элементов произведения без операций: элементы не
+* приводятся к int, суммы считаются в long long через умножение на вектор - op(A) * (op(B) * 1)
+* и (1^T * op(A)) * op(B), O((m + n) * k) вместо умножения матриц. Совпадают с rowSums и др.,
+* если элементы произведения помещаются в int.
+*/
+std::vector<long long> exactRowSums(const ProductExpr& e, int num_threads);
+std::vector<long long> exactColumnSums(const ProductExpr& e, int num_threads);
+long long exactSum(const ProductExpr& e, int num_threads);
+
+/**
+* @brief След квадратного выражения: нужны только диагональные элементы произведения, каждый -
+* скалярное произведение строки op(A) и столбца op(B) в int, всего O(n * k) операций.
+* @throw std::invalid_argument если выражение не квадратное
+*/
+template <class E, expr_detail::EnableIfExpression<E> = 0>
+long long trace(const E& e, int num_threads) {
+    expr_detail::checkThreads("trace", num_threads);
+    if (e.rows() != e.cols()) {
+        throw std::invalid_argument("trace: выражение не квадратное");
+    }
+    const ProductExpr& p = e.product();
+    long long total = 0;
+    #pragma omp parallel for reduction(+ : total) num_threads(num_threads) schedule(static)
+    for (int i = 0; i < e.rows(); i++) {
+        total += e.apply(i, i, expr_detail::diagonal(p, i));
+    }
+    return total;
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "MatrixStorage.h"
+
+namespace fixed_detail {
+
+// c[0:N] += a * b[0:N]: длина известна при компиляции, цикл векторизуется без остатка
+template <int N>
+inline void axpyRow(int a, const int* b, int* c) {
+    #pragma omp simd
+    for (int j = 0; j < N; j++) {
+        c[j] += a * b[j];
+    }
+}
+
+// Строка результата: цикл по общему измерению развёрнут при компиляции (свёртка по P...)
+template <int N, std::size_t... P>
+inline void rowProduct(const int* a, const int* B, std::ptrdiff_t ldb, int* acc, std::index_sequence<P...>) {
+    (axpyRow<N>(a[P], B + static_cast<std::ptrdiff_t>(P) * ldb, acc), ...);
+}
+
+} // namespace fixed_detail
+
+/**
+* @brief Умножение C = A * B квадратных матриц размера N, известного при компиляции.
+* Цикл по общему измерению развёрнут, строка накопителя (N int) хранится в регистрах,
+* внутренний цикл не имеет остатка. Операнды - с произвольным шагом строки.
+*/
+template <int N>
+inline void multiplyFixed(const int* A, std::ptrdiff_t lda, const int* B, std::ptrdiff_t ldb, int* C,
+    std::ptrdiff_t ldc) {
+    static_assert(N > 0, "multiplyFixed: размер должен быть положительным");
+    for (int i = 0; i < N; i++) {
+        alignas(MATRIX_ALIGNMENT) int acc[N] = {};
+        fixed_detail::rowProduct<N>(A + i * lda, B, ldb, acc, std::make_index_sequence<N>());
+        for (int j = 0; j < N; j++) {
+            C[i * ldc + j] = acc[j];
+        }
+    }
+}
+
+/**
+* @brief Выбор специализации multiplyFixed по размеру, известному только во время выполнения.
+*
+* @return false, если для n специализации нет (поддерживаются 4, 8, 16, 32)
+*/
+inline bool multiplyFixedDispatch(int n, const int* A, std::ptrdiff_t lda, const int* B, std::ptrdiff_t ldb,
+    int* C, std::ptrdiff_t ldc) {
+    switch (n) {
+    case 4: multiplyFixed<4>(A, lda, B, ldb, C, ldc); return true;
+    case 8: multiplyFixed<8>(A, lda, B, ldb, C, ldc); return true;
+    case 16: multiplyFixed<16>(A, lda, B, ldb, C, ldc); return true;
+    case 32: multiplyFixed<32>(A, lda, B, ldb, C, ldc); return true;
+    default: return false;
+    }
+}
+
+/**
+* @brief Квадратная матрица размера N, известного при компиляции, без динамической памяти.
+* Строки хранятся подряд, начало выровнено по MATRIX_ALIGNMENT.
+*/
+template <int N>
+class FixedMatrix {
+private:
+    alignas(MATRIX_ALIGNMENT) std::array<int, N * N> values{};
+
+public:
+    static constexpr int size = N;
+
+    FixedMatrix() = default;
+
+    /**
+    * @brief Копия матрицы, заданной вектором векторов.
+    * @throw std::invalid_argument если размер не N x N
+    */
+    static FixedMatrix fromNested(const std::vector<std::vector<int>>& nested) {
+        if (static_cast<int>(nested.size()) != N) {
+            throw std::invalid_argument("FixedMatrix::fromNested: неверное количество строк");
+        }
+        FixedMatrix m;
+        for (int i = 0; i < N; i++) {
+            if (static_cast<int>(nested[i].size()) != N) {
+                throw std::invalid_argument("FixedMatrix::fromNested: неверная длина строки");
+            }
+            std::copy(nested[i].begin(), nested[i].end(), m.row(i));
+        }
+        return m;
+    }
+
+    int* data() { return values.data(); }
+    const int* data() const { return values.data(); }
+    int* row(int i) { return values.data() + i * N; }
+    const int* row(int i) const { return values.data() + i * N; }
+    int& operator()(int i, int j) { return values[i * N + j]; }
+    const int& operator()(int i, int j) const { return values[i * N + j]; }
+
+    MatrixView<int> view() const { return MatrixView<int>(values.data(), N, N, N); }
+
+    std::vector<std::vector<int>> toNested() const {
+        std::vector<std::vector<int>> nested(N);
+        for (int i = 0; i < N; i++) {
+            nested[i].assign(row(i), row(i) + N);
+        }
+        return nested;
+    }
+
+    bool operator==(const FixedMatrix& other) const { return values == other.values; }
+    bool operator!=(const FixedMatrix& other) const { return values != other.values; }
+};
+
+/**
+* @brief Произведение матриц фиксированного размера (см. multiplyFixed).
+*/
+template <int N>
+FixedMatrix<N> multiply(const FixedMatrix<N>& A, const FixedMatrix<N>& B) {
+    FixedMatrix<N> C;
+    multiplyFixed<N>(A.data(), N, B.data(), N, C.data(), N);
+    return C;
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include "MatrixStorage.h"
+
+/**
+* @brief Размеры блоков (тайлов) для блочного умножения.
+* tile_i x tile_k - блок A, упаковываемый для кэша L2; tile_k x tile_j - панель B для L2/L3.
+*/
+struct BlockSizes {
+    int tile_i = 64;
+    int tile_j = 512;
+    int tile_k = 256;
+};
+
+/**
+* @brief Операция над операндом GEMM: N - как хранится, T - транспонированный.
+*/
+enum class Transpose { N, T };
+
+/**
+* @brief Блочное умножение C = A * B с упаковкой блоков A и панелей B в непрерывные буферы.
+* Внутренним ядром служит микроядро, выбранное по CPUID (см. activeMicroKernel).
+* Размеры берутся из представлений: A - m x k, B - k x n, C - m x n.
+*
+* @param A - первый операнд
+* @param B - второй операнд
+* @param C - указатель на элемент (0, 0) результата
+* @param ldc - шаг строки результата
+* @param tiles - размеры блоков
+* @throw std::invalid_argument если размеры операндов не согласованы или размер блока не положителен
+*/
+void multiplyBlockedKernel(MatrixView<int> A, MatrixView<int> B, int* C, std::ptrdiff_t ldc,
+    const BlockSizes& tiles);
+
+/**
+* @brief Буферы упакованных блоков A и панелей B для последовательного блочного умножения.
+* Переиспользуются между вызовами одного потока: выделяются заново, только если их не хватает.
+*/
+struct PackingBuffers {
+    AlignedMatrix<int> A;
+    AlignedMatrix<int> B;
+};
+
+/**
+* @brief multiplyBlockedKernel с буферами упаковки вызывающего кода - для серий небольших
+* произведений, где выделение буферов на каждое умножение сравнимо с самим умножением.
+*/
+void multiplyBlockedKernel(MatrixView<int> A, MatrixView<int> B, int* C, std::ptrdiff_t ldc,
+    const BlockSizes& tiles, PackingBuffers& buffers);
+
+/**
+* @brief Установка планировки для циклов schedule(runtime) вызывающего потока (omp_set_schedule).
+*
+* @param type - static, dynamic или guided
+* @param chunk - размер порции, 0 - по умолчанию OpenMP
+* @throw std::invalid_argument если тип неизвестен или chunk < 0
+*/
+void setRuntimeSchedule(const std::string& type, int chunk);
+
+/**
+* @brief Параллельный вариант multiplyBlockedKernel: панель B упаковывается совместно всеми
+* потоками, блоки строк A распределяются между потоками через omp for с планировкой type.
+*
+* @param num_threads - количество потоков
+* @param type - планировка распределения блоков строк: static, dynamic, guided или steal (см. gemmKernel)
+* @param chunk - размер порции блоков строк, 0 - по умолчанию OpenMP
+*/
+void multiplyBlockedKernelParallel(MatrixView<int> A, MatrixView<int> B, int* C, std::ptrdiff_t ldc,
+    const BlockSizes& tiles, int num_threads, const std::string& type = "static", int chunk = 0);
+
+/**
+* @brief Общее умножение C = alpha * op(A) * op(B) + beta * C, op(A) - m x k, op(B) - k x n.
+* Устроено как multiplyBlockedKernelParallel; транспонирование учитывается при упаковке:
+* A^T упаковывается чтением строк хранимой матрицы подряд, B^T - построчно по столбцам op(B),
+* так что в обоих случаях исходные данные читаются с единичным шагом. alpha применяется
+* при упаковке A, C масштабируется на beta один раз перед накоплением (beta = 0 - C не читается).
+* При type = steal плитки C (tile_i x tile_j) выполняются общим пулом ThreadPool::shared()
+* не более чем num_threads потоками, каждая - целиком по k в упакованные панели своего потока
+* пула, выделяемые один раз на вызов; chunk не используется.
+*
+* @param opA, opB - операции над хранимыми A и B
+* @param C - указатель на элемент (0, 0) результата m x n
+* @param num_threads - количество потоков
+* @param type - планировка распределения блоков строк: static, dynamic, guided или steal
+* @param chunk - размер порции блоков строк, 0 - по умолчанию OpenMP
+* @throw std::invalid_argument если внутренние размеры op(A) и op(B) не совпадают, размер блока
+* не положителен или планировка неверна
+*/
+void gemmKernel(Transpose opA, Transpose opB, int alpha, MatrixView<int> A, MatrixView<int> B, int beta,
+    int* C, std::ptrdiff_t ldc, const BlockSizes& tiles, int num_threads, const std::string& type = "static",
+    int chunk = 0);
+
+/**
+* @brief Эпилог умножения плитками: получает готовую плитку op(A) * op(B) размера rows x cols
+* с началом в (i0, j0) и шагом строки ldt. worker - номер потока OpenMP (0 .. num_threads - 1);
+* потоки вызывают эпилог одновременно для разных плиток. Эпилог не должен бросать исключений.
+*/
+using TileEpilogue = std::function<void(int worker, int i0, int j0, int rows, int cols, const int* tile,
+    std::ptrdiff_t ldt)>;
+
+/**
+* @brief Умножение op(A) * op(B) без общей матрицы результата: каждая плитка tile_i x tile_j
+* накапливается по всему общему измерению в буфере потока (остаётся в L2) и сразу передаётся
+* эпилогу, который записывает или сворачивает её. Для каждой полосы столбцов панель op(B)
+* упаковывается на всю глубину k один раз (tile_j x k элементов), блоки строк распределяются
+* между потоками статически. Так C не читается обратно после умножения, а при свёртке не
+* выделяется вовсе.
+*
+* @param num_threads - количество потоков
+* @throw std::invalid_argument если внутренние размеры op(A) и op(B) не совпадают или размер блока
+* не положителен
+*/
+void gemmTilesKernel(Transpose opA, Transpose opB, MatrixView<int> A, MatrixView<int> B, const BlockSizes& tiles,
+    int num_threads, const TileEpilogue& epilogue);
+
+/**
+* @brief Рекурсивное умножение квадратных матриц по схеме Штрассена-Винограда (7 умножений
+* на уровень). Семь подпроизведений верхних уровней выполняются как задачи OpenMP, ниже порога
+* cutoff используется блочное ядро. Размер, не равный size * 2^k, дополняется нулями.
+* Результат побитово совпадает с классическим умножением (целочисленная арифметика).
+*
+* @param cutoff - размер блока, начиная с которого рекурсия прекращается
+* @param num_threads - количество потоков
+* @throw std::invalid_argument если операнды не квадратные одного размера или cutoff <= 0
+*/
+void multiplyStrassenKernel(MatrixView<int> A, MatrixView<int> B, int* C, std::ptrdiff_t ldc,
+    int cutoff, int num_threads);
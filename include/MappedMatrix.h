@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Kernels.h"
+#include "MatrixStorage.h"
+
+/**
+* @brief Заголовок двоичного файла матрицы (64 байта). За ним следуют rows строк по ld элементов
+* (row-major), поэтому при отображении файла в память строки выровнены по MATRIX_ALIGNMENT.
+*/
+struct MatrixFileHeader {
+    char magic[8];              ///< "PPMATRIX"
+    std::uint32_t version;      ///< MATRIX_FILE_VERSION
+    std::uint32_t elementType;  ///< ElementType, поддерживается только Int32
+    std::int64_t rows;
+    std::int64_t cols;
+    std::int64_t ld;            ///< шаг строки в элементах
+    std::uint8_t reserved[24];
+};
+
+constexpr std::uint32_t MATRIX_FILE_VERSION = 1;
+
+/**
+* @brief Матрица int в двоичном файле, отображённом в память (mmap, на Windows - MapViewOfFile).
+* Страницы подгружаются ОС по обращению, поэтому матрица может быть больше оперативной памяти;
+* prefetchRows/releaseRows подсказывают ОС (madvise), какие строки скоро понадобятся
+* и какие больше не нужны. Объект только перемещается.
+*/
+class MappedMatrix {
+public:
+    enum class Mode { ReadOnly, ReadWrite };
+
+    MappedMatrix() = default;
+    MappedMatrix(const MappedMatrix&) = delete;
+    MappedMatrix& operator=(const MappedMatrix&) = delete;
+    MappedMatrix(MappedMatrix&& other) noexcept;
+    MappedMatrix& operator=(MappedMatrix&& other) noexcept;
+    ~MappedMatrix();
+
+    /**
+    * @brief Создаёт (перезаписывает) файл матрицы rows x cols, заполненной нулями, и открывает его
+    * для записи. Шаг строки - как у AlignedMatrix.
+    *
+    * @throw std::invalid_argument если размеры отрицательны
+    * @throw std::runtime_error при ошибке создания или отображения файла
+    */
+    static MappedMatrix create(const std::string& path, int rows, int cols);
+
+    /**
+    * @brief Открывает существующий файл матрицы.
+    *
+    * @throw std::runtime_error при ошибке открытия, неверном заголовке или размере файла
+    */
+    static MappedMatrix open(const std::string& path, Mode mode = Mode::ReadOnly);
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    std::ptrdiff_t ld() const { return ld_; }
+    bool writable() const { return mode_ == Mode::ReadWrite; }
+    /// @brief Размер данных (без заголовка), байт
+    std::size_t dataBytes() const { return static_cast<std::size_t>(rows_) * ld_ * sizeof(int); }
+
+    const int* data() const { return data_; }
+    /// @throw std::invalid_argument если файл открыт только для чтения
+    int* mutableData();
+    MatrixView<int> view() const { return MatrixView<int>(data_, rows_, cols_, ld_); }
+
+    /// @brief Асинхронная подгрузка строк [begin, end) (MADV_WILLNEED)
+    void prefetchRows(int begin, int end) const;
+
+    /**
+    * @brief Строки [begin, end) больше не нужны (MADV_DONTNEED): страницы освобождаются,
+    * изменённые страницы файла, открытого для записи, сначала отдаются на запись.
+    */
+    void releaseRows(int begin, int end) const;
+
+    /// @brief Синхронная запись изменений на диск
+    /// @throw std::runtime_error при ошибке записи
+    void flush() const;
+
+private:
+    void* base_ = nullptr;      ///< начало отображения (заголовок)
+    std::size_t mappedBytes_ = 0;
+    int* data_ = nullptr;
+    int rows_ = 0;
+    int cols_ = 0;
+    std::ptrdiff_t ld_ = 0;
+    Mode mode_ = Mode::ReadOnly;
+
+    static MappedMatrix map(const std::string& path, Mode mode, bool create, std::size_t createBytes);
+    void advise(int begin, int end, bool willNeed) const;
+    void unmap();
+};
+
+/**
+* @brief Запись матрицы в двоичный файл (см. MatrixFileHeader).
+* @throw std::runtime_error при ошибке записи
+*/
+void writeMatrixFile(const std::string& path, MatrixView<int> m);
+
+/**
+* @brief Параметры умножения матриц из файлов.
+*/
+struct OutOfCoreOptions {
+    std::size_t memoryBudget = std::size_t(1) << 30;   ///< байт на одновременно используемые панели A, B и C
+    BlockSizes tiles;           ///< блоки ядра; tile_k задаёт высоту панели B
+    int num_threads = 1;
+};
+
+/**
+* @brief Потоковое умножение C = A * B матриц в файлах. C считается панелями строк: высота
+* панели выбирается так, чтобы панель A (rows x k), панель C (rows x n) и две панели B
+* (tile_k x n, текущая и следующая) помещались в memoryBudget. Для каждой панели C панели B
+* читаются последовательно и передаются параллельному блочному ядру (gemmKernel) прямо из
+* отображённой памяти; пока считается текущая панель B, следующая (и следующая панель A)
+* подгружается ОС по MADV_WILLNEED. Использованные панели A и C освобождаются, панели B - если
+* B целиком не помещается в половину бюджета.
+*
+* @return время выполнения в секундах
+* @throw std::invalid_argument если размеры не согласованы или C открыта только для чтения
+*/
+double multiplyOutOfCore(const MappedMatrix& A, const MappedMatrix& B, MappedMatrix& C,
+    const OutOfCoreOptions& options = OutOfCoreOptions());
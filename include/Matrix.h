@@ -1,39 +1,293 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <string>
+#include "MatrixStorage.h"
+#include "Kernels.h"
+#include "NarrowKernels.h"
+#include "Telemetry.h"
+#include "Sparse.h"
+#include "Affinity.h"
+#include "PerfCounters.h"
+#include "Verify.h"
+#include "ResultCache.h"
+#include "Expression.h"
+#include <memory>
+#include <mutex>
+
+class AutoTuner;
+
+/// Плитка итераций (i, j) multiplyParallel при планировке steal по умолчанию
+constexpr int STEAL_TILE_ROWS = 8;
+constexpr int STEAL_TILE_COLS = 128;
+
+/// Плитка C, пересчитываемая recompute: строки плитки делят строки B, прочитанные из кэша
+constexpr int RECOMPUTE_TILE_ROWS = 8;
+constexpr int RECOMPUTE_TILE_COLS = 256;
 
 /**
-* @brief Класс матриц. Инициализирует три квадратные матрицы A, B, C типа int размером n*n.
-* Перемножает A и B линейно и с использованием распараллеливания.
+* @brief Класс матриц. Хранит матрицы A, B, C типа int для умножения C = op(A) * op(B), где
+* op(A) - m x k, op(B) - k x n, C - m x n; по умолчанию все три квадратные размером n*n.
+* Перемножает A и B линейно и с использованием распараллеливания; общий случай
+* C = alpha * op(A) * op(B) + beta * C с транспонированием операндов выполняет gemm.
+* Матрицы хранятся в непрерывных выровненных буферах (AlignedMatrix), геттеры в виде
+* вектора векторов возвращают кэшируемую копию. Память под матрицы выделяется лениво:
+* до первого заполнения или умножения матрица считается нулевой. Вместо собственного буфера
+* матрица может ссылаться на внешнюю память вызывающего кода (adoptMatrixA/B/C).
+* Константные методы (геттеры, view) можно вызывать одновременно из нескольких потоков, пока
+* объект не изменяется: ленивое выделение и заполнение копий выполняются под мьютексом.
 */
 class Matrix {
 private:
-    std::vector<std::vector<int>> A, B, C;
-    int n;
+    /// Пустые до первого обращения, выделяются в allocate (в том числе из константных методов)
+    mutable AlignedMatrix<int> A, B, C;
+    int m, n, k;
+    Transpose opA, opB;
+
+    /// Размеры хранимой матрицы
+    struct Shape {
+        int rows;
+        int cols;
+    };
+    Shape shapeA, shapeB, shapeC;
+
+    /// Копия матрицы в виде вектора векторов для совместимых геттеров, сбрасывается при изменении
+    struct NestedCache {
+        std::vector<std::vector<int>> data;
+        bool valid = false;
+    };
+    mutable NestedCache nestedA, nestedB, nestedC;
+
+    const std::vector<std::vector<int>>& nested(const AlignedMatrix<int>& mat, NestedCache& cache, Shape shape) const;
+
+    /// Мьютекс ленивого заполнения в константных методах; копия объекта получает свой мьютекс
+    struct LazyLock {
+        std::mutex mutex;
+        LazyLock() = default;
+        LazyLock(const LazyLock&) {}
+        LazyLock& operator=(const LazyLock&) { return *this; }
+    };
+    mutable LazyLock lazy;
+
+    /// Выделение и параллельное обнуление (first touch) ещё не выделенной матрицы
+    void allocate(AlignedMatrix<int>& mat, Shape shape) const;
+    /// Выделение всех трёх матриц перед умножением
+    void prepareOperands();
+    /// @throw std::invalid_argument если операнды транспонированы (методы, кроме gemm)
+    void requireUntransposed(const char* method) const;
+    /// @throw std::invalid_argument если размер не совпадает с shape
+    void checkShape(int rows, int cols, Shape shape) const;
+    /// @throw std::invalid_argument если число строк или длина любой строки не совпадает с shape
+    void checkNested(const std::vector<std::vector<int>>& nestedM, Shape shape) const;
+    /// Перенос вектора векторов в собственный буфер mat с освобождением строк источника
+    void moveIn(AlignedMatrix<int>& mat, std::vector<std::vector<int>>&& nestedM, Shape shape);
+
+    /// Копии A и B в узких типах для multiplyNarrow, строятся по требованию и сбрасываются при изменении
+    struct NarrowCopies {
+        AlignedMatrix<std::int8_t> A8, B8;
+        AlignedMatrix<std::int16_t> A16, B16;
+        bool valid8 = false;
+        bool valid16 = false;
+    };
+    NarrowCopies narrow;
+
+    /// Плотности и CSR-копии A и B для multiplySparse, строятся по требованию и сбрасываются при изменении
+    /// (для внешних буферов - при каждом умножении, см. prepareOperands)
+    struct SparseCopies {
+        CsrMatrix A, B;
+        CscMatrix Bc;
+        double densityA = 0;
+        double densityB = 0;
+        bool validDensity = false;
+        bool validA = false;
+        bool validB = false;
+        bool validBc = false;
+    };
+    SparseCopies sparse;
+    SparsePath lastSparse = SparsePath::Dense;
+
+    /// Телеметрия последнего вызова multiplyParallel
+    MultiplyTelemetry telemetry;
+
+    /// Закрепление потоков и размещение страниц для параллельных умножений
+    AffinityConfig affinityConfig;
+
+    /// Для какого числа потоков и каких буферов уже выполнено размещение по узлам NUMA
+    struct Placement {
+        int threads = 0;
+        const int* a = nullptr;
+        const int* b = nullptr;
+        const int* c = nullptr;
+    };
+    Placement placement;
+
+    /// Аппаратные счётчики: включены ли и показания последнего умножения
+    bool perfEnabled = false;
+    PerfReport perf;
+
+    /// Раундов проверки Фрейвалдса после каждого умножения, 0 - без проверки
+    int verifyRounds = 0;
+
+    /**
+    * Изменения A и B после последнего умножения для recompute. Пока current, C = A * B всюду,
+    * кроме отмеченных строк и столбцов, с точностью до поправки C += U * V, где left - столбцы U
+    * (длины m), right - строки V (длины n); поправки вычисляются в момент изменения по текущим A и B.
+    */
+    struct PendingUpdates {
+        bool current = false;
+        std::vector<char> rows;
+        std::vector<char> cols;
+        std::vector<std::vector<int>> left;
+        std::vector<std::vector<int>> right;
+    };
+    PendingUpdates updates;
+
+    /// Кэш результатов (может быть общим для нескольких Matrix) и хеши текущих A и B
+    std::shared_ptr<ResultCache> resultCache;
+    struct OperandHashes {
+        MatrixHash a;
+        MatrixHash b;
+        bool valid = false;
+    };
+    OperandHashes hashes;
+    /// Ключ текущего умножения после промаха: результат сохраняется в кэш после умножения
+    ResultKey pendingKey;
+    bool cachePending = false;
+    bool cacheHit = false;
+
+    /**
+    * Поиск результата текущих A и B в кэше (хеширование на num_threads потоках) для умножения
+    * в типе type с накоплением accumulation. При попадании результат копируется в C, seconds -
+    * время поиска с копированием.
+    */
+    bool loadCached(int num_threads, double& seconds, ElementType type = ElementType::Int32,
+        Accumulation accumulation = Accumulation::Int32);
+    /// Сохранение C в кэш после промаха, seconds - время умножения
+    void storeCached(double seconds);
+
+    /// Сброс копий A и B в других форматах (узких, разреженных) и их хешей после изменения операндов
+    void dropDerivedCopies();
+    /// Сброс производных от A и B данных после замены операндов, C больше не соответствует им
+    void markOperandsChanged();
+    /// Сброс отметок изменений; current - C равна произведению текущих A и B
+    void resetUpdates(bool current);
+    /// Подготовка к изменению части операнда на месте: собственная копия внешнего буфера, сброс копий
+    void beginUpdate(const char* method, AlignedMatrix<int>& mat, NestedCache& cache, Shape shape);
+
+    /**
+    * Закрепление потоков команды OpenMP из num_threads потоков по affinityConfig (команда
+    * переиспользует потоки между параллельными областями, поэтому закрепление действует и в ядре)
+    * и размещение страниц (placeOperands). Поток 0 команды - вызывающий: возвращается его прежний
+    * набор ядер, который восстанавливается при уничтожении результата в конце умножения.
+    */
+    SavedAffinity applyAffinity(int num_threads);
+    /**
+    * Размещение страниц по плану закрепления plan: B - чередованием по узлам, строки A и C -
+    * статическими панелями на узлах потоков, как их распределяют ядра. Размещение повторяется
+    * только при смене буферов или числа потоков.
+    */
+    void placeOperands(int num_threads, const std::vector<int>& plan);
+
+    /**
+    * Запуск и остановка счётчиков на num_threads потоках команды OpenMP (1 - только вызывающий
+    * поток, 0 - счётчики не собираются) вне замеряемого интервала; ничего не делают, если
+    * счётчики выключены.
+    */
+    void countersBegin(int num_threads);
+    void countersEnd(int num_threads);
+
+    /**
+    * Проверка C == alpha * op(A) * op(B) после умножения вне замеряемого интервала,
+    * если включена setVerification.
+    * @throw std::runtime_error если результат не прошёл проверку
+    */
+    void checkResult(int num_threads, int alpha = 1) const;
 
 public:
     /**
-    * @brief Конструктор матриц заданных размеров. Выделяет память под них.
-    * Результирующая матрица C инициализируется как нулевая.
+    * @brief Конструктор матриц заданных размеров. Память не выделяется: матрицы создаются
+    * при первом заполнении или умножении (C - при первом умножении) и обнуляются параллельно,
+    * чтобы страницы разместились на узлах NUMA потоков, которые затем будут с ними работать.
     *
     * @param n - количество строк и столбцов каждой матрицы
+    * @throw std::invalid_argument если n < 0
     */
     Matrix(int n);
 
+    /**
+    * @brief Конструктор для умножения прямоугольных матриц: op(A) - m x k, op(B) - k x n.
+    * Хранимая A имеет размер m x k при opA = N и k x m при opA = T (аналогично B), все сеттеры
+    * проверяют размеры хранимых матриц. Транспонированные операнды умножает только gemm.
+    *
+    * @throw std::invalid_argument если один из размеров отрицателен
+    */
+    Matrix(int m, int n, int k, Transpose opA = Transpose::N, Transpose opB = Transpose::N);
+
     /**
     * @brief Сеттер первой матрицы A. Копирует матрицу newA во внутреннюю переменную класса.
     *
     * @param newA - матрица, которая будет скопирована в A 
+    * @throw std::invalid_argument если размер newA не совпадает с размером хранимой A
     */
     void setMatrixA(const std::vector<std::vector<int>>& newA); 
     /**
     * @brief Сеттер второй матрицы B. Копирует матрицу newB во внутреннюю переменную класса.
     *
     * @param newB - матрица, которая будет скопирована в B
+    * @throw std::invalid_argument если размер newB не совпадает с размером хранимой B
     */
     void setMatrixB(const std::vector<std::vector<int>>& newB);
+
     /**
-    * @brief Геттер первой матрицы A.
+    * @brief Сеттер результирующей матрицы C - начального значения для gemm с beta != 0.
+    * Во внешний буфер C (adoptMatrixC) значение записывается на месте.
+    *
+    * @throw std::invalid_argument если размер newC не m x n
+    */
+    void setMatrixC(const std::vector<std::vector<int>>& newC);
+
+    /**
+    * @brief Сеттеры, забирающие вектор векторов: строки источника освобождаются по мере
+    * копирования, поэтому пиковая память не превышает одной матрицы и строки. После вызова newA пуст.
+    *
+    * @throw std::invalid_argument если размер не совпадает с размером хранимой матрицы (источник при этом не изменяется)
+    */
+    void setMatrixA(std::vector<std::vector<int>>&& newA);
+    void setMatrixB(std::vector<std::vector<int>>&& newB);
+
+    /**
+    * @brief Сеттеры без копирования: буфер newA становится матрицей A.
+    *
+    * @throw std::invalid_argument если размер newA не совпадает с размером хранимой A
+    */
+    void setMatrixA(AlignedMatrix<int>&& newA);
+    void setMatrixB(AlignedMatrix<int>&& newB);
+
+    /**
+    * @brief Использование внешнего буфера как матрицы A без копирования. Буфер должен жить,
+    * пока он используется объектом, и не изменяется им: последующие setMatrixA и initialize
+    * заменяют его собственным буфером. Вызывающий код может менять буфер между вызовами (но не
+    * во время умножения): производные копии (узкие, разреженные, хеши для кэша результатов и
+    * геттер getMatrixA) для внешних операндов строятся заново при каждом умножении.
+    *
+    * @param data - указатель на элемент (0, 0)
+    * @param rows, cols - размеры, должны совпадать с размером хранимой матрицы
+    * @param ld - шаг между началами соседних строк в элементах (ld >= cols)
+    * @throw std::invalid_argument если размер не совпадает с размером хранимой матрицы, ld < cols или data == nullptr
+    */
+    void adoptMatrixA(const int* data, int rows, int cols, std::ptrdiff_t ld);
+    void adoptMatrixB(const int* data, int rows, int cols, std::ptrdiff_t ld);
+
+    /**
+    * @brief Использование внешнего буфера как результирующей матрицы C: умножения пишут
+    * результат прямо в него.
+    *
+    * @throw std::invalid_argument если размер не m x n, ld < cols или data == nullptr
+    */
+    void adoptMatrixC(int* data, int rows, int cols, std::ptrdiff_t ld);
+    /**
+    * @brief Геттер первой матрицы A. Возвращает копию в виде вектора векторов, которая
+    * остаётся актуальной до следующего изменения матрицы.
     *
     * @return константная ссылка на матрицу A
     */
@@ -52,23 +306,274 @@ public:
     const std::vector<std::vector<int>>& getMatrixC() const;
 
     /**
-    * @brief Заполнение матриц A и B случайными числами в диапазоне [-100, 100].
+    * @brief Невладеющие представления матриц A, B, C без копирования (только для чтения).
+    * Действительны, пока объект существует и матрица не заменена. Невыделенная матрица
+    * выделяется и обнуляется при первом обращении.
+    */
+    MatrixView<int> viewA() const;
+    MatrixView<int> viewB() const;
+    MatrixView<int> viewC() const;
+
+    /**
+    * @brief Ленивое произведение op(A) * op(B) операндов объекта для выражений с эпилогами
+    * (см. Expression.h), например evaluate(relu(m.lazyProduct() + D), threads) или
+    * rowSums(m.lazyProduct() * 2, threads). Действительно, пока операнды не заменены.
+    */
+    ProductExpr lazyProduct() const;
+
+    /// @brief Размер матриц (для прямоугольного случая - число столбцов C)
+    int size() const;
+
+    /// @brief Размеры умножения: C - rows() x cols(), общий размер op(A) и op(B) - inner()
+    int rows() const;
+    int cols() const;
+    int inner() const;
+
+    /**
+    * @brief Телеметрия по потокам последнего вызова multiplyParallel.
+    */
+    const MultiplyTelemetry& lastTelemetry() const;
+
+    /**
+    * @brief Правило закрепления потоков и размещения страниц по узлам NUMA для параллельных
+    * умножений через OpenMP (для планировки steal потоки закрепляет пул). По умолчанию ничего
+    * не закрепляется. Закрепление потоков OpenMP сохраняется и после умножения.
+    *
+    * @throw std::invalid_argument если в списке ядер Explicit есть недоступное процессу ядро
+    */
+    void setAffinity(const AffinityConfig& config);
+    const AffinityConfig& affinity() const;
+
+    /**
+    * @brief Включение аппаратных счётчиков (perf_event_open, Linux): каждое следующее умножение
+    * собирает по каждому своему потоку такты, инструкции, промахи L1d, LLC и dTLB на время
+    * работы ядра. Для планировки steal (потоки пула) счётчики не собираются.
+    */
+    void enablePerfCounters(bool enabled = true);
+
+    /// @brief Счётчики последнего умножения (пусто, если выключены или недоступны для этого варианта)
+    const PerfReport& lastPerfCounters() const;
+
+    /**
+    * @brief Вероятностная проверка C == op(A) * op(B) (freivaldsCheck) за O(rounds * n^2)
+    * вместо повторного умножения. Неверный результат проходит её с вероятностью не больше 2^-rounds.
+    * После gemm с alpha != 1 или beta != 0 равенство, как правило, не выполняется.
+    *
+    * @param rounds - число раундов от 1 до FREIVALDS_MAX_ROUNDS
+    * @param num_threads - количество потоков проверки
+    * @param seed - ключ случайных векторов
+    * @throw std::invalid_argument если rounds вне допустимого диапазона
+    */
+    bool verify(int rounds = FREIVALDS_ROUNDS, int num_threads = 1, std::uint64_t seed = FREIVALDS_SEED) const;
+
+    /**
+    * @brief Режим проверки: каждое следующее умножение проверяется rounds раундами Фрейвалдса
+    * на том же числе потоков (вне замеряемого времени) и при ошибке бросает std::runtime_error.
+    * gemm проверяется только при beta = 0. 0 - выключить.
+    * @throw std::invalid_argument если rounds вне диапазона от 0 до FREIVALDS_MAX_ROUNDS
+    */
+    void setVerification(int rounds = FREIVALDS_ROUNDS);
+
+    /**
+    * @brief Заполнение матриц A и B случайными числами в диапазоне [-100, 100] со случайным seed.
     */
     void initialize();
 
     /**
-    * Линейное умножение матриц (без распараллеливания).
+    * @brief Воспроизводимое заполнение A и B случайными числами в диапазоне [-100, 100].
+    * Заполнение параллельное, результат зависит только от seed и n, но не от числа потоков.
+    *
+    * @param seed - начальное значение счётчикового генератора
+    */
+    void initialize(std::uint64_t seed);
+
+    /**
+    * @brief То же с заданной долей ненулевых элементов в A и B (остальные элементы - нули),
+    * для проверки и замеров разреженного умножения.
+    *
+    * @param densityA, densityB - доля ненулевых позиций, от 0 до 1
+    */
+    void initialize(std::uint64_t seed, double densityA, double densityB);
+
+    /**
+    * Линейное умножение матриц (без распараллеливания). Для квадратных n = 4, 8, 16, 32
+    * используется ядро фиксированного размера (multiplyFixed).
     *
     * @return время выполнения в секундах
     */
     double multiplyLinear();
 
     /**
-    * @brief Параллельное умножение матриц с использованием OpenMP.
+    * @brief Параллельное умножение матриц с использованием OpenMP. Итерации (i, j) делятся
+    * между потоками одной команды с планировкой schedule(runtime). Во время работы ничего
+    * не выводит: каждый поток заполняет свою ячейку телеметрии (время, итерации, ядро),
+    * результат доступен через lastTelemetry().
+    *
+    * При type = steal итерации выполняются общим пулом с перехватом работы (ThreadPool::shared())
+    * плитками по chunk строк (0 - STEAL_TILE_ROWS) и STEAL_TILE_COLS столбцов; одновременные вызовы
+    * из разных потоков делят пул, а не создают свои команды.
     *
     * @param num_threads - количество потоков
-    * @param type - тип планирования для OpenMP: static, dynamic или guided
+    * @param type - тип планирования: static, dynamic, guided (OpenMP) или steal (пул потоков)
+    * @param chunk - размер порции итераций (i, j), 0 - по умолчанию OpenMP
+    * @return время выполнения в секундах
+    * @throw std::invalid_argument если тип планирования неизвестен, num_threads <= 0 или chunk < 0
+    */
+    double multiplyParallel(int num_threads, const std::string& type, int chunk = 0);
+
+    /**
+    * @brief Блочное (тайловое) умножение без распараллеливания. Блоки A и панели B
+    * упаковываются в непрерывные буферы, чтобы рабочий набор помещался в кэш.
+    *
+    * @param tile_i - высота блока A и C
+    * @param tile_j - ширина панели B и C
+    * @param tile_k - глубина блока по общему измерению
     * @return время выполнения в секундах
+    * @throw std::invalid_argument если размер блока не положителен
     */
-    double multiplyParallel(int num_threads, const std::string& type);
+    double multiplyBlocked(int tile_i = BlockSizes().tile_i, int tile_j = BlockSizes().tile_j,
+        int tile_k = BlockSizes().tile_k);
+
+    /**
+    * @brief Параллельное блочное умножение с использованием OpenMP.
+    *
+    * @param num_threads - количество потоков
+    * @param tile_i - высота блока A и C
+    * @param tile_j - ширина панели B и C
+    * @param tile_k - глубина блока по общему измерению
+    * @param type - планировка распределения блоков строк: static, dynamic, guided или steal (плитки
+    * tile_i x tile_j на общем пуле потоков)
+    * @param chunk - размер порции блоков строк, 0 - по умолчанию OpenMP
+    * @return время выполнения в секундах
+    * @throw std::invalid_argument если размер блока не положителен или планировка неверна
+    */
+    double multiplyBlockedParallel(int num_threads, int tile_i = BlockSizes().tile_i,
+        int tile_j = BlockSizes().tile_j, int tile_k = BlockSizes().tile_k,
+        const std::string& type = "static", int chunk = 0);
+
+    /**
+    * @brief Умножение по схеме Штрассена-Винограда с задачами OpenMP. Для больших n
+    * (от ~2048) выполняет меньше операций, чем классическое O(n^3) умножение.
+    *
+    * @param num_threads - количество потоков
+    * @param cutoff - размер подматрицы, ниже которого используется блочное ядро
+    * @return время выполнения в секундах
+    * @throw std::invalid_argument если cutoff <= 0 или матрицы не квадратные
+    */
+    double multiplyStrassen(int num_threads, int cutoff = 512);
+
+    /**
+    * @brief Параллельное умножение с хранением A и B в узком типе (int8/int16) и расширенным
+    * накоплением. Узкие копии строятся при первом вызове и переиспользуются до изменения A или B;
+    * время их построения не входит в результат. Результат совпадает с multiplyLinear.
+    *
+    * @param num_threads - количество потоков
+    * @param type - тип хранения операндов
+    * @param accumulation - Int32 (как multiplyLinear) или Int64Checked (накопление в int64 с проверкой)
+    * @return время выполнения в секундах
+    * @throw std::out_of_range если элементы A или B не помещаются в type
+    * @throw std::overflow_error если при Int64Checked элемент результата не помещается в int
+    */
+    double multiplyNarrow(int num_threads, ElementType type, Accumulation accumulation = Accumulation::Int32);
+
+    /**
+    * @brief Параллельное блочное умножение с конфигурацией (потоки, блоки, планировка, порция),
+    * подобранной автотюнером для текущего n. При первом обращении для данного размера
+    * выполняется настройка, её время в результат не входит.
+    *
+    * @return время выполнения в секундах
+    */
+    double multiplyAuto();
+
+    /**
+    * @brief То же с явно заданным автотюнером (например, с отдельным файлом кэша).
+    */
+    double multiplyAuto(AutoTuner& tuner);
+
+    /**
+    * @brief Общее умножение C = alpha * op(A) * op(B) + beta * C с операциями, заданными
+    * в конструкторе. Блочное параллельное ядро: транспонирование учитывается при упаковке,
+    * поэтому все варианты op читают исходные данные с единичным шагом.
+    *
+    * @param alpha, beta - множители
+    * @param num_threads - количество потоков
+    * @param type - планировка распределения блоков строк: static, dynamic или guided
+    * @param chunk - размер порции блоков строк, 0 - по умолчанию OpenMP
+    * @return время выполнения в секундах
+    * @throw std::invalid_argument если планировка неверна
+    */
+    double gemm(int alpha, int beta, int num_threads, const std::string& type = "static", int chunk = 0);
+
+    /**
+    * @brief Умножение с разреженными операндами. В режиме Auto плотность A и B измеряется
+    * (один раз до изменения операндов), и операнды с плотностью ниже threshold переводятся в CSR/CSC:
+    * разреженный B - spmm плотная x CSC, разреженный A - spmm CSR x плотная, оба - spgemm (CSR x CSR),
+    * ни одного - параллельное блочное умножение. Измерение плотности и построение CSR-копий
+    * в результат не входят. Результат совпадает с multiplyLinear.
+    *
+    * @param num_threads - количество потоков
+    * @param path - Auto или принудительный выбор операндов в CSR
+    * @param threshold - порог плотности для Auto
+    * @return время выполнения в секундах
+    */
+    double multiplySparse(int num_threads, SparsePath path = SparsePath::Auto,
+        double threshold = SPARSE_DENSITY_THRESHOLD);
+
+    /// @brief Путь, выбранный последним вызовом multiplySparse
+    SparsePath lastSparsePath() const;
+
+    /**
+    * @brief Замена строк A [row0, row0 + rows.size()); recompute пересчитает те же строки C.
+    * @throw std::invalid_argument если строки выходят за пределы A, имеют неверную длину
+    * или операнды транспонированы (то же для остальных частичных изменений)
+    */
+    void updateRowsA(int row0, const std::vector<std::vector<int>>& rows);
+
+    /**
+    * @brief Замена строк B [row0, row0 + rows.size()); recompute добавит к C поправку
+    * A[:, строки] * (новые строки - старые) ранга rows.size().
+    */
+    void updateRowsB(int row0, const std::vector<std::vector<int>>& rows);
+
+    /**
+    * @brief Замена столбцов B [col0, col0 + columns.size()), columns[j] - столбец длины k;
+    * recompute пересчитает те же столбцы C.
+    */
+    void updateColumnsB(int col0, const std::vector<std::vector<int>>& columns);
+
+    /**
+    * @brief A += u * v^T (u длины m, v длины k); recompute добавит к C поправку u * (v^T * B).
+    */
+    void rankOneUpdateA(const std::vector<int>& u, const std::vector<int>& v);
+
+    /**
+    * @brief B += u * v^T (u длины k, v длины n); recompute добавит к C поправку (A * u) * v^T.
+    */
+    void rankOneUpdateB(const std::vector<int>& u, const std::vector<int>& v);
+
+    /**
+    * @brief Обновление C после частичных изменений A и B с последнего умножения за
+    * O(изменений * n^2): сначала поправка ранга r (параллельное блочное ядро с beta = 1), затем
+    * отмеченные строки и столбцы C пересчитываются плитками RECOMPUTE_TILE_ROWS x RECOMPUTE_TILE_COLS,
+    * распределёнными между потоками. Если C не была вычислена умножением после последней замены
+    * операндов целиком или изменений столько, что частичный пересчёт не дешевле, выполняется
+    * multiplyBlockedParallel. Результат совпадает с multiplyLinear.
+    *
+    * @param num_threads - количество потоков
+    * @return время выполнения в секундах
+    */
+    double recompute(int num_threads);
+
+    /**
+    * @brief Подключение кэша результатов (nullptr - отключить). Умножения, кроме recompute и gemm
+    * с alpha != 1 или beta != 0, сначала ищут результат по хешам содержимого A и B (хеши
+    * запоминаются до изменения операндов, хеши внешних буферов adoptMatrixA/B считаются при
+    * каждом умножении): при попадании C копируется из кэша без умножения,
+    * а возвращается время поиска; при промахе результат сохраняется после умножения.
+    */
+    void setResultCache(std::shared_ptr<ResultCache> cache);
+    std::shared_ptr<ResultCache> getResultCache() const;
+
+    /// @brief Взят ли результат последнего умножения из кэша
+    bool lastCacheHit() const;
 };
@@ -0,0 +1,234 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// Выравнивание начала буфера и каждой строки (размер кэш-линии), байт
+constexpr std::size_t MATRIX_ALIGNMENT = 64;
+
+/**
+* @brief Невладеющее представление матрицы с построчным (row-major) хранением и шагом строки ld.
+* Используется ядрами умножения для чтения операндов без копирования.
+*/
+template <typename T>
+class MatrixView {
+private:
+    const T* ptr;
+    int rows_;
+    int cols_;
+    std::ptrdiff_t ld_;
+
+public:
+    MatrixView() : ptr(nullptr), rows_(0), cols_(0), ld_(0) {}
+
+    /**
+    * @param data - указатель на элемент (0, 0)
+    * @param rows - количество строк
+    * @param cols - количество столбцов
+    * @param ld - шаг между началами соседних строк в элементах (ld >= cols)
+    */
+    MatrixView(const T* data, int rows, int cols, std::ptrdiff_t ld)
+        : ptr(data), rows_(rows), cols_(cols), ld_(ld) {}
+
+    const T* data() const { return ptr; }
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    std::ptrdiff_t ld() const { return ld_; }
+    bool empty() const { return rows_ == 0 || cols_ == 0; }
+
+    const T* row(int i) const { return ptr + i * ld_; }
+    const T& operator()(int i, int j) const { return ptr[i * ld_ + j]; }
+
+    /**
+    * @brief Подматрица размера rows x cols, начинающаяся с элемента (i0, j0).
+    */
+    MatrixView block(int i0, int j0, int rows, int cols) const {
+        return MatrixView(ptr + i0 * ld_ + j0, rows, cols, ld_);
+    }
+};
+
+/**
+* @brief Владеющее хранилище матрицы: один непрерывный буфер, выровненный по MATRIX_ALIGNMENT,
+* строки хранятся подряд с шагом ld, дополненным до целого числа кэш-линий.
+*/
+template <typename T>
+class AlignedMatrix {
+private:
+    T* ptr = nullptr;
+    int rows_ = 0;
+    int cols_ = 0;
+    std::ptrdiff_t ld_ = 0;
+    bool owned_ = true;
+
+    static T* allocate(std::size_t count) {
+        if (count == 0) return nullptr;
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(MATRIX_ALIGNMENT)));
+    }
+
+    static void release(T* p) {
+        if (p) ::operator delete(p, std::align_val_t(MATRIX_ALIGNMENT));
+    }
+
+public:
+    AlignedMatrix() = default;
+
+    /**
+    * @brief Выделяет память под матрицу rows x cols и заполняет её нулями (включая дополнение строк).
+    */
+    AlignedMatrix(int rows, int cols)
+        : ptr(allocate(static_cast<std::size_t>(rows) * paddedLeadingDimension(cols))),
+          rows_(rows), cols_(cols), ld_(paddedLeadingDimension(cols)) {
+        if (ptr) std::memset(ptr, 0, sizeBytes());
+    }
+
+    /**
+    * @brief Выделяет память без заполнения. Страницы не затрагиваются до первой записи, поэтому
+    * при заполнении параллельными потоками (first touch) они размещаются на узлах NUMA этих потоков.
+    */
+    static AlignedMatrix uninitialized(int rows, int cols) {
+        AlignedMatrix m;
+        m.ld_ = paddedLeadingDimension(cols);
+        m.ptr = allocate(static_cast<std::size_t>(rows) * m.ld_);
+        m.rows_ = rows;
+        m.cols_ = cols;
+        return m;
+    }
+
+    /**
+    * @brief Невладеющая обёртка над внешним буфером без копирования. Буфер должен жить дольше
+    * обёртки и не освобождается ею; выравнивание и дополнение строк не требуются.
+    *
+    * @param data - указатель на элемент (0, 0)
+    * @param ld - шаг между началами соседних строк в элементах
+    * @throw std::invalid_argument если размеры отрицательны, ld < cols или data == nullptr при непустой матрице
+    */
+    static AlignedMatrix adopt(T* data, int rows, int cols, std::ptrdiff_t ld) {
+        if (rows < 0 || cols < 0 || ld < cols) {
+            throw std::invalid_argument("AlignedMatrix::adopt: неверные размеры или шаг строки");
+        }
+        if (!data && rows > 0 && cols > 0) {
+            throw std::invalid_argument("AlignedMatrix::adopt: нулевой указатель");
+        }
+        AlignedMatrix m;
+        m.ptr = data;
+        m.rows_ = rows;
+        m.cols_ = cols;
+        m.ld_ = ld;
+        m.owned_ = false;
+        return m;
+    }
+
+    /**
+    * @brief Копия всегда владеет памятью и имеет стандартный шаг строки, в том числе копия
+    * обёртки над внешним буфером.
+    */
+    AlignedMatrix(const AlignedMatrix& other)
+        : ptr(allocate(static_cast<std::size_t>(other.rows_) * paddedLeadingDimension(other.cols_))),
+          rows_(other.rows_), cols_(other.cols_), ld_(paddedLeadingDimension(other.cols_)) {
+        if (!ptr) return;
+        if (other.owned_ && other.ld_ == ld_) {
+            std::memcpy(ptr, other.ptr, sizeBytes());
+            return;
+        }
+        for (int i = 0; i < rows_; i++) {
+            std::copy(other.row(i), other.row(i) + cols_, row(i));
+            std::fill(row(i) + cols_, row(i) + ld_, T(0));
+        }
+    }
+
+    AlignedMatrix(AlignedMatrix&& other) noexcept
+        : ptr(std::exchange(other.ptr, nullptr)), rows_(std::exchange(other.rows_, 0)),
+          cols_(std::exchange(other.cols_, 0)), ld_(std::exchange(other.ld_, 0)),
+          owned_(std::exchange(other.owned_, true)) {}
+
+    AlignedMatrix& operator=(const AlignedMatrix& other) {
+        if (this != &other) {
+            AlignedMatrix copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    AlignedMatrix& operator=(AlignedMatrix&& other) noexcept {
+        AlignedMatrix moved(std::move(other));
+        swap(moved);
+        return *this;
+    }
+
+    ~AlignedMatrix() {
+        if (owned_) release(ptr);
+    }
+
+    void swap(AlignedMatrix& other) noexcept {
+        std::swap(ptr, other.ptr);
+        std::swap(rows_, other.rows_);
+        std::swap(cols_, other.cols_);
+        std::swap(ld_, other.ld_);
+        std::swap(owned_, other.owned_);
+    }
+
+    /**
+    * @brief Шаг строки для заданного числа столбцов: кратен кэш-линии, а если строка
+    * занимает целое число страниц по 4 КБ, добавляется ещё одна линия, чтобы соседние
+    * строки не попадали в один и тот же набор кэша.
+    */
+    static std::ptrdiff_t paddedLeadingDimension(int cols) {
+        const std::ptrdiff_t perLine = static_cast<std::ptrdiff_t>(MATRIX_ALIGNMENT / sizeof(T));
+        std::ptrdiff_t ld = (static_cast<std::ptrdiff_t>(cols) + perLine - 1) / perLine * perLine;
+        if (ld > 0 && (ld * static_cast<std::ptrdiff_t>(sizeof(T))) % 4096 == 0) ld += perLine;
+        return ld;
+    }
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    std::ptrdiff_t ld() const { return ld_; }
+    bool empty() const { return rows_ == 0 || cols_ == 0; }
+    /// @brief false для обёртки над внешним буфером (см. adopt)
+    bool owned() const { return owned_; }
+    std::size_t storageSize() const { return static_cast<std::size_t>(rows_) * ld_; }
+    std::size_t sizeBytes() const { return storageSize() * sizeof(T); }
+
+    T* data() { return ptr; }
+    const T* data() const { return ptr; }
+    T* row(int i) { return ptr + i * ld_; }
+    const T* row(int i) const { return ptr + i * ld_; }
+    T& operator()(int i, int j) { return ptr[i * ld_ + j]; }
+    const T& operator()(int i, int j) const { return ptr[i * ld_ + j]; }
+
+    MatrixView<T> view() const { return MatrixView<T>(ptr, rows_, cols_, ld_); }
+    operator MatrixView<T>() const { return view(); }
+
+    /**
+    * @brief Копирует матрицу, заданную вектором векторов. Размеры должны совпадать с текущими.
+    * Все размеры проверяются до записи: при ошибке содержимое не меняется.
+    * @throw std::invalid_argument если число строк или длина любой строки не совпадает
+    */
+    void assign(const std::vector<std::vector<T>>& nested) {
+        if (static_cast<int>(nested.size()) != rows_) {
+            throw std::invalid_argument("AlignedMatrix::assign: неверное количество строк");
+        }
+        for (int i = 0; i < rows_; i++) {
+            if (static_cast<int>(nested[i].size()) != cols_) {
+                throw std::invalid_argument("AlignedMatrix::assign: неверная длина строки");
+            }
+        }
+        for (int i = 0; i < rows_; i++) {
+            std::copy(nested[i].begin(), nested[i].end(), row(i));
+        }
+    }
+
+    /**
+    * @brief Копия матрицы в виде вектора векторов (без дополнения строк).
+    */
+    std::vector<std::vector<T>> toNested() const {
+        std::vector<std::vector<T>> nested(rows_);
+        for (int i = 0; i < rows_; i++) {
+            nested[i].assign(row(i), row(i) + cols_);
+        }
+        return nested;
+    }
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+* @brief Сигнатура микроядра: вычисляет блок C размера mr x nr по упакованным полосам.
+*
+* @param kc - глубина по общему измерению
+* @param Ap - полоса A: kc столбцов по mr элементов подряд
+* @param Bp - полоса B: kc строк по nr элементов подряд
+* @param C - указатель на элемент (0, 0) блока результата
+* @param ldc - шаг строки результата
+* @param accumulate - прибавлять к C (true) или перезаписывать (false)
+*/
+using MicroKernelFn = void (*)(int kc, const int* Ap, const int* Bp, int* C, std::ptrdiff_t ldc, bool accumulate);
+
+/**
+* @brief Описание микроядра с регистровой блокировкой: размеры блока и функция вычисления.
+*/
+struct MicroKernel {
+    const char* name;
+    int mr;
+    int nr;
+    MicroKernelFn compute;
+};
+
+/**
+* @brief Наборы инструкций x86, доступные процессору и сохраняемые ОС (флаги CPUID и XCR0).
+* На других архитектурах все флаги false.
+*/
+struct CpuFeatures {
+    bool avx2 = false;
+    bool avx512f = false;
+    bool avx512bw = false;
+    bool avx512vnni = false;
+};
+
+/**
+* @brief Возможности процессора, определённые один раз при первом обращении.
+*/
+const CpuFeatures& cpuFeatures();
+
+/**
+* @brief Название модели процессора (строка CPUID brand или model name из /proc/cpuinfo),
+* "unknown" если определить не удалось.
+*/
+std::string cpuModelName();
+
+/**
+* @brief Микроядро, выбранное по CPUID при первом обращении (AVX-512, AVX2 или переносимое скалярное).
+*/
+const MicroKernel& activeMicroKernel();
+
+/**
+* @brief Все микроядра, которые поддерживает текущий процессор, от самого быстрого к скалярному.
+*/
+std::vector<const MicroKernel*> availableMicroKernels();
+
+/**
+* @brief Принудительный выбор микроядра по имени ("avx512", "avx2", "scalar").
+*
+* @return false если ядро неизвестно или не поддерживается процессором
+*/
+bool setActiveMicroKernel(const std::string& name);
+
+// Реализации для конкретных наборов инструкций; каждая собирается в отдельной единице трансляции
+// со своими флагами компилятора и вызывается только после проверки CPUID.
+void microKernelScalar(int kc, const int* Ap, const int* Bp, int* C, std::ptrdiff_t ldc, bool accumulate);
+#ifdef MATRIX_X86_KERNELS
+void microKernelAvx2(int kc, const int* Ap, const int* Bp, int* C, std::ptrdiff_t ldc, bool accumulate);
+void microKernelAvx512(int kc, const int* Ap, const int* Bp, int* C, std::ptrdiff_t ldc, bool accumulate);
+#endif
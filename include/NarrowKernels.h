@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include "MatrixStorage.h"
+
+/**
+* @brief Тип элементов, в котором хранятся операнды A и B при умножении.
+* Значения из initialize() ([-100, 100]) помещаются в любой из них.
+*/
+enum class ElementType {
+    Int8,
+    Int16,
+    Int32
+};
+
+/**
+* @brief Тип накопителя суммы: int32 (как в multiplyLinear) или int64 с проверкой того,
+* что итоговое значение помещается в int.
+*/
+enum class Accumulation {
+    Int32,
+    Int64Checked
+};
+
+/**
+* @brief Копия матрицы в узком целочисленном типе T.
+*
+* @throw std::out_of_range если какой-либо элемент не помещается в T
+*/
+template <typename T>
+AlignedMatrix<T> narrowCopy(MatrixView<int> src) {
+    AlignedMatrix<T> dst(src.rows(), src.cols());
+    for (int i = 0; i < src.rows(); i++) {
+        const int* s = src.row(i);
+        T* d = dst.row(i);
+        for (int j = 0; j < src.cols(); j++) {
+            if (s[j] < std::numeric_limits<T>::min() || s[j] > std::numeric_limits<T>::max()) {
+                throw std::out_of_range("narrowCopy: значение не помещается в узкий тип");
+            }
+            d[j] = static_cast<T>(s[j]);
+        }
+    }
+    return dst;
+}
+
+/**
+* @brief Параллельное умножение C = A * B с узкими входами TIn и накопителем TAcc.
+* При наличии поддержки процессора используются упакованные умножения со сложением:
+* int16 -> int32 через pmaddwd (AVX2), int8 -> int32 через vpdpbusd (AVX-512 VNNI).
+* В остальных случаях - переносимое ядро с расширением до TAcc.
+*
+* Инстанцировано для TIn = int8_t, int16_t, int32_t и TAcc = int32_t, int64_t.
+*
+* @throw std::invalid_argument если число столбцов A не равно числу строк B
+*/
+template <typename TIn, typename TAcc>
+void multiplyNarrowKernel(MatrixView<TIn> A, MatrixView<TIn> B, TAcc* C, std::ptrdiff_t ldc, int num_threads);
+
+/**
+* @brief Параллельное умножение с накоплением в int64 и записью в int. Инстанцировано для
+* TIn = int8_t, int16_t, int32_t.
+*
+* @throw std::overflow_error если хотя бы один элемент результата не помещается в int
+* @throw std::invalid_argument если число столбцов A не равно числу строк B
+*/
+template <typename TIn>
+void multiplyCheckedKernel(MatrixView<TIn> A, MatrixView<TIn> B, int* C, std::ptrdiff_t ldc, int num_threads);
+
+// Ядра для конкретных наборов инструкций (вызываются только после проверки CPUID).
+// Bp - упакованные панели B, см. NarrowKernels.cpp; вычисляются строки [0, rows) результата.
+#ifdef MATRIX_X86_KERNELS
+void narrowKernelInt16Avx2(const std::int16_t* A, std::ptrdiff_t lda, int rows, const std::int16_t* Bp,
+    int kpairs, int n, int* C, std::ptrdiff_t ldc);
+void narrowKernelInt8Vnni(const std::uint8_t* A, std::ptrdiff_t lda, int rows, const std::int8_t* Bp,
+    int kquads, int n, const int* correction, int* C, std::ptrdiff_t ldc);
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+
+/**
+* @brief Показания аппаратных счётчиков за одно умножение (только пользовательский режим).
+* Значение -1 - счётчик недоступен (не Linux, запрещено perf_event_paranoid, нет в ОС/процессоре).
+* Если ОС мультиплексирует счётчики, значения масштабируются на долю времени, когда счётчик работал.
+*/
+struct PerfCounts {
+    long long cycles = -1;
+    long long instructions = -1;
+    long long l1dMisses = -1;   ///< промахи L1 данных при чтении
+    long long llcMisses = -1;   ///< промахи последнего уровня кэша при чтении
+    long long dtlbMisses = -1;  ///< промахи TLB данных при чтении
+
+    /// @brief Хотя бы один счётчик доступен
+    bool available() const;
+    /// @brief Инструкций за такт, 0 если неизвестно
+    double ipc() const;
+    /// @brief Поэлементная сумма; недоступный в одном из слагаемых счётчик остаётся доступным в другом
+    PerfCounts& operator+=(const PerfCounts& other);
+};
+
+/**
+* @brief Счётчики всех потоков, выполнявших умножение (индекс - номер потока в команде).
+*/
+struct PerfReport {
+    std::vector<PerfCounts> threads;
+
+    PerfCounts total() const;
+};
+
+/**
+* @brief Обнуление и запуск счётчиков вызывающего потока. Счётчики открываются
+* (perf_event_open, pid = 0) при первом вызове в потоке и остаются открытыми до его завершения.
+*/
+void perfThreadStart();
+
+/**
+* @brief Остановка счётчиков вызывающего потока и их показания с момента perfThreadStart.
+*/
+PerfCounts perfThreadStop();
+
+/// @brief Можно ли открыть хотя бы один счётчик в вызывающем потоке
+bool perfCountersAvailable();
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include "MatrixStorage.h"
+
+/**
+* @brief Счётчиковый генератор (смешивание splitmix64): значение зависит только от ключа и номера,
+* поэтому элементы можно вычислять в любом порядке и любым числом потоков.
+*
+* @param key - ключ потока случайных чисел
+* @param counter - номер значения в потоке
+* @return 64 псевдослучайных бита
+*/
+inline std::uint64_t counterRandom(std::uint64_t key, std::uint64_t counter) {
+    std::uint64_t z = key + (counter + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+* @brief Равномерное целое в [lo, hi] по ключу и номеру (умножение со сдвигом вместо деления с остатком).
+*/
+inline int counterUniform(std::uint64_t key, std::uint64_t counter, int lo, int hi) {
+    const std::uint64_t range = static_cast<std::uint64_t>(static_cast<std::int64_t>(hi) - lo + 1);
+    const std::uint64_t bits = counterRandom(key, counter) >> 32;
+    return static_cast<int>(lo + static_cast<std::int64_t>((bits * range) >> 32));
+}
+
+/**
+* @brief Параллельное заполнение матрицы случайными числами в [lo, hi]. Элемент (i, j) равен
+* counterUniform(counterRandom(seed, stream), i * cols + j, lo, hi) независимо от числа потоков.
+* Строки распределяются между потоками статически, как в параллельных ядрах умножения,
+* поэтому при первом касании страницы попадают на узел NUMA потока, который будет их обрабатывать.
+*
+* @param stream - номер независимого потока чисел при общем seed (например, 0 для A и 1 для B)
+* @param density - доля элементов, заполняемых случайными числами, остальные - нули; при density < 1
+* выбор нулевых позиций тоже определяется seed и stream
+*/
+void fillRandom(AlignedMatrix<int>& m, std::uint64_t seed, std::uint64_t stream, int lo, int hi,
+    double density = 1.0);
+
+/**
+* @brief Параллельное обнуление матрицы (включая дополнение строк) с тем же распределением строк,
+* что и в fillRandom. Применяется к буферам из AlignedMatrix::uninitialized для размещения first touch.
+*/
+void firstTouchZero(AlignedMatrix<int>& m);
@@ -0,0 +1,107 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "Kernels.h"
+#include "MatrixStorage.h"
+#include "NarrowKernels.h"
+
+/**
+* @brief 128-битный хеш содержимого матрицы. Строки хешируются NH (сумма произведений пар
+* элементов, сдвинутых на ключ, по модулю 2^64) с двумя независимыми ключами, хеши строк
+* перемешиваются с номером строки и складываются. Вероятность совпадения хешей разных матриц
+* того же размера - порядка 2^-64. Дополнение строк не учитывается.
+*/
+struct MatrixHash {
+    std::uint64_t low = 0;
+    std::uint64_t high = 0;
+
+    bool operator==(const MatrixHash& other) const { return low == other.low && high == other.high; }
+};
+
+/**
+* @brief Хеш матрицы, строки распределяются между потоками. Зависит только от размера и значений
+* элементов, но не от шага строки.
+*/
+MatrixHash hashMatrix(MatrixView<int> m, int num_threads);
+
+/**
+* @brief Ключ результата: хеши хранимых операндов, размеры умножения, транспонирование,
+* тип элементов, в котором умножаются операнды, и накопление (результат с проверкой
+* переполнения не подменяется результатом без неё).
+*/
+struct ResultKey {
+    MatrixHash a;
+    MatrixHash b;
+    int m = 0, n = 0, k = 0;
+    Transpose opA = Transpose::N;
+    Transpose opB = Transpose::N;
+    ElementType type = ElementType::Int32;
+    Accumulation accumulation = Accumulation::Int32;
+
+    bool operator==(const ResultKey& other) const;
+};
+
+struct ResultKeyHash {
+    std::size_t operator()(const ResultKey& key) const { return static_cast<std::size_t>(key.a.low ^ (key.b.low * 31)); }
+};
+
+/**
+* @brief Счётчики кэша результатов.
+*/
+struct CacheStats {
+    long long hits = 0;
+    long long misses = 0;
+    long long evictions = 0;
+    double hashSeconds = 0;     ///< суммарное время хеширования операндов
+    double missSeconds = 0;     ///< суммарное время умножений при промахах
+    std::size_t bytes = 0;      ///< память под хранимые результаты
+    std::size_t entries = 0;
+
+    /// @brief Доля попаданий, 0 если обращений не было
+    double hitRate() const;
+};
+
+/**
+* @brief Кэш результатов умножения по содержимому операндов с вытеснением давно не использованных
+* (LRU) при превышении бюджета памяти. Потокобезопасен и может быть общим для нескольких Matrix.
+* Результаты хранятся неизменяемыми: найденный результат остаётся действительным и после вытеснения.
+*/
+class ResultCache {
+public:
+    /// @param budgetBytes - наибольший суммарный размер хранимых результатов
+    explicit ResultCache(std::size_t budgetBytes);
+
+    /// @brief Результат по ключу (попадание делает его самым новым) или nullptr; считает попадания и промахи
+    std::shared_ptr<const AlignedMatrix<int>> find(const ResultKey& key);
+
+    /**
+    * @brief Сохранение копии C. Давно не использованные результаты вытесняются, пока новый не
+    * поместится в бюджет; результат больше бюджета не сохраняется.
+    */
+    void insert(const ResultKey& key, MatrixView<int> C);
+
+    void recordHashing(double seconds);
+    void recordMultiply(double seconds);
+
+    CacheStats stats() const;
+    std::size_t budget() const { return budgetBytes; }
+
+    /// @brief Удаление всех результатов (счётчики сохраняются)
+    void clear();
+
+private:
+    struct Entry {
+        ResultKey key;
+        std::shared_ptr<const AlignedMatrix<int>> C;
+    };
+
+    std::size_t budgetBytes;
+    mutable std::mutex mutex;
+    std::list<Entry> entries;   ///< от самого нового к самому старому
+    std::unordered_map<ResultKey, std::list<Entry>::iterator, ResultKeyHash> index;
+    CacheStats counters;
+};
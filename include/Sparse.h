@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "MatrixStorage.h"
+
+/// Плотность операнда (доля ненулевых элементов), ниже которой multiplySparse переводит его в CSR/CSC
+constexpr double SPARSE_DENSITY_THRESHOLD = 0.1;
+
+/**
+* @brief Разреженная матрица в формате CSR: ненулевые элементы строки i занимают позиции
+* [rowPtr[i], rowPtr[i + 1]) массивов colIdx и values, столбцы внутри строки упорядочены.
+*/
+struct CsrMatrix {
+    int rows = 0;
+    int cols = 0;
+    std::vector<std::size_t> rowPtr;
+    std::vector<int> colIdx;
+    std::vector<int> values;
+
+    std::size_t nnz() const { return values.size(); }
+
+    /// @brief Перевод плотной матрицы в CSR (параллельно по строкам)
+    static CsrMatrix fromDense(MatrixView<int> dense, int num_threads);
+};
+
+/**
+* @brief Разреженная матрица в формате CSC: ненулевые элементы столбца j занимают позиции
+* [colPtr[j], colPtr[j + 1]) массивов rowIdx и values, строки внутри столбца упорядочены.
+*/
+struct CscMatrix {
+    int rows = 0;
+    int cols = 0;
+    std::vector<std::size_t> colPtr;
+    std::vector<int> rowIdx;
+    std::vector<int> values;
+
+    std::size_t nnz() const { return values.size(); }
+
+    /// @brief Перевод плотной матрицы в CSC (параллельно по столбцам)
+    static CscMatrix fromDense(MatrixView<int> dense, int num_threads);
+};
+
+/**
+* @brief Какие операнды multiplySparse хранит в разреженном формате. Auto - по измеренной плотности.
+*/
+enum class SparsePath {
+    Auto,
+    Dense,
+    SparseA,
+    SparseB,
+    SparseAB
+};
+
+/**
+* @brief Доля ненулевых элементов матрицы (параллельный подсчёт), 0 для пустой матрицы.
+*/
+double density(MatrixView<int> m, int num_threads);
+
+/**
+* @brief Выбор пути для Auto: операнд с плотностью ниже threshold хранится в разреженном формате.
+*/
+SparsePath chooseSparsePath(double densityA, double densityB, double threshold);
+
+/**
+* @brief C = A * B, A - плотная, B - CSC. Между потоками распределяются панели строк A:
+* панель транспонируется во временный буфер, и столбец j результата считается как сумма
+* строк транспонированной панели с весами из столбца j матрицы B (векторизуется по строкам
+* панели), после чего транспонируется обратно в C. Результат совпадает с плотным умножением
+* (целочисленная арифметика).
+*
+* @throw std::invalid_argument если число столбцов A не равно числу строк B
+*/
+void spmmKernel(MatrixView<int> A, const CscMatrix& B, int* C, std::ptrdiff_t ldc, int num_threads);
+
+/**
+* @brief C = A * B, A - CSR, B - плотная: для каждого ненулевого a(i, p) к строке i результата
+* прибавляется плотная строка p матрицы B (векторизуется).
+*
+* @throw std::invalid_argument если число столбцов A не равно числу строк B
+*/
+void spmmKernel(const CsrMatrix& A, MatrixView<int> B, int* C, std::ptrdiff_t ldc, int num_threads);
+
+/**
+* @brief C = A * B для двух CSR-матриц (схема Густавсона) с плотным результатом: строка C
+* служит накопителем, в неё прибавляются разреженные строки B.
+*
+* @throw std::invalid_argument если число столбцов A не равно числу строк B
+*/
+void spgemmKernel(const CsrMatrix& A, const CsrMatrix& B, int* C, std::ptrdiff_t ldc, int num_threads);
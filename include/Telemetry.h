@@ -0,0 +1,51 @@
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+#include "MatrixStorage.h"
+
+/**
+* @brief Запись одного потока о параллельном умножении. Времена отсчитываются от момента
+* входа в параллельную область, секунды.
+*/
+struct ThreadTelemetry {
+    int thread = 0;
+    double start = 0;           ///< начало работы потока
+    double end = 0;             ///< окончание работы потока (без ожидания остальных)
+    long long iterations = 0;   ///< выполнено итераций (элементов C)
+    int cpu = -1;               ///< номер ядра, на котором поток начал работу, -1 если неизвестен
+    int node = -1;              ///< узел NUMA этого ядра, -1 если неизвестен
+
+    double busy() const { return end - start; }
+};
+
+/**
+* @brief Ячейка буфера телеметрии на отдельной кэш-линии: потоки пишут каждый в свою ячейку
+* без блокировок и без ложного разделения.
+*/
+struct alignas(MATRIX_ALIGNMENT) TelemetrySlot {
+    ThreadTelemetry record;
+};
+
+/**
+* @brief Телеметрия последнего параллельного умножения.
+*/
+struct MultiplyTelemetry {
+    std::string schedule;
+    int requestedThreads = 0;
+    double totalTime = 0;
+    std::vector<ThreadTelemetry> threads;
+
+    /// @brief Дисбаланс нагрузки: максимальное время работы потока / среднее; 1 - идеальный баланс
+    double imbalance() const;
+};
+
+/**
+* @brief Номер логического ядра, на котором выполняется вызывающий поток, -1 если неизвестен.
+*/
+int currentCpu();
+
+/**
+* @brief Вывод телеметрии по потокам: время старта и работы, число и доля итераций, ядро.
+*/
+void printTelemetry(std::ostream& out, const MultiplyTelemetry& telemetry);
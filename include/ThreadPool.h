@@ -0,0 +1,78 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Тип планировки, при котором параллельные ядра выполняются на общем пуле потоков, а не командой OpenMP
+constexpr const char* WORK_STEALING_SCHEDULE = "steal";
+
+/**
+* @brief Постоянный пул потоков с перехватом работы (work stealing) для двумерных задач.
+*
+* Задача - прямоугольник rows x cols, разбитый на плитки. Плитки раздаются непрерывными
+* диапазонами в очереди (deque) участников задачи: участник берёт плитки с конца своей очереди,
+* а освободившись, забирает плитки с начала очередей других участников той же задачи.
+* Участников не больше maxWorkers, поэтому число одновременно работающих над задачей потоков
+* ограничено так же, как в OpenMP. Задачи нескольких вызывающих потоков выполняются одним пулом:
+* у каждого потока пула своя очередь задач, и начальный поток для следующей задачи сдвигается
+* по кругу, поэтому одновременные вызовы делят ядра, а не создают свои команды потоков.
+*/
+class ThreadPool {
+public:
+    /**
+    * @brief Тело задачи: плитка [i0, i1) x [j0, j1), worker - номер потока пула (0..size()-1).
+    */
+    using TileBody = std::function<void(int worker, int i0, int i1, int j0, int j1)>;
+
+    /**
+    * @param count - количество потоков
+    * @param pin - закрепить потоки за ядрами по правилу AffinityPolicy::Compact
+    * @throw std::invalid_argument если count <= 0
+    */
+    explicit ThreadPool(int count, bool pin = true);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    /// @brief Общий пул процесса: по потоку на логическое ядро, потоки закреплены
+    static ThreadPool& shared();
+
+    int size() const { return static_cast<int>(workers.size()); }
+
+    /**
+    * @brief Выполняет body для всех плиток tileRows x tileCols прямоугольника rows x cols
+    * и ждёт завершения. Вызывающий поток в вычислениях не участвует. Исключение из body
+    * (первое) пробрасывается вызывающему после завершения остальных плиток.
+    *
+    * @param maxWorkers - наибольшее число потоков пула, работающих над задачей
+    * @throw std::invalid_argument если размеры плиток или maxWorkers не положительны
+    */
+    void parallelFor2D(int rows, int cols, int tileRows, int tileCols, int maxWorkers, const TileBody& body);
+
+private:
+    struct Job;
+
+    /// Участие потока в задаче: slot - номер его очереди плиток в задаче
+    struct Assignment {
+        std::shared_ptr<Job> job;
+        int slot;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<Assignment> assignments;
+        std::thread thread;
+        bool stopping = false;  ///< защищён mutex этого потока
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex startMutex;
+    int nextStart = 0;
+
+    void run(int index, int cpu);
+};
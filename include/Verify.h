@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include "Kernels.h"
+#include "MatrixStorage.h"
+
+/// Раундов проверки по умолчанию: вероятность пропустить неверный результат не больше 2^-10
+constexpr int FREIVALDS_ROUNDS = 10;
+/// Наибольшее число раундов: случайные векторы всех раундов берутся из одного 64-битного значения
+constexpr int FREIVALDS_MAX_ROUNDS = 64;
+/// Ключ случайных векторов по умолчанию
+constexpr std::uint64_t FREIVALDS_SEED = 0x5EEDF4E1ULL;
+
+/**
+* @brief Вероятностная проверка Фрейвалдса C == alpha * op(A) * op(B) за O(rounds * n^2):
+* для случайных векторов x из нулей и единиц сравниваются C * x и alpha * op(A) * (op(B) * x).
+* Все раунды выполняются за один проход по каждой матрице, строки распределяются между потоками.
+* Арифметика по модулю 2^32, как при переполнении int в ядрах умножения. Верный результат
+* проходит проверку всегда, неверный - с вероятностью не больше 2^-rounds.
+*
+* @param opA, opB - транспонирование операндов, как в gemmKernel: op(A) - m x k, op(B) - k x n, C - m x n
+* @param rounds - число раундов от 1 до FREIVALDS_MAX_ROUNDS
+* @param seed - ключ случайных векторов (counterRandom)
+* @return true, если равенство выполнено во всех раундах
+* @throw std::invalid_argument если размеры не согласованы или rounds вне допустимого диапазона
+*/
+bool freivaldsCheck(Transpose opA, Transpose opB, int alpha, MatrixView<int> A, MatrixView<int> B,
+    MatrixView<int> C, int rounds, std::uint64_t seed, int num_threads);
@@ -0,0 +1,305 @@
+#include "Affinity.h"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include "Telemetry.h"
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#if defined(__linux__)
+// Константы mbind из <numaif.h>: libnuma не требуется
+constexpr int MPOL_PREFERRED_MODE = 1;
+constexpr int MPOL_INTERLEAVE_MODE = 3;
+constexpr unsigned MPOL_MF_MOVE_FLAG = 1u << 1;
+constexpr int MAX_NODES = 1024;
+
+// Список вида "0-3,8,10-11"
+std::vector<int> parseCpuList(const std::string& text) {
+    std::vector<int> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (item.empty() || item == "\n") continue;
+        const std::size_t dash = item.find('-');
+        const int first = std::stoi(item.substr(0, dash));
+        const int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+        for (int value = first; value <= last; value++) values.push_back(value);
+    }
+    return values;
+}
+
+std::string readLine(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+bool mbindRange(void* data, std::size_t bytes, int mode, const std::vector<int>& nodes) {
+    if (!data || bytes == 0) return true;
+    unsigned long mask[MAX_NODES / (8 * sizeof(unsigned long))] = {};
+    for (int node : nodes) {
+        if (node < 0 || node >= MAX_NODES) return false;
+        mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+    }
+    // mbind требует адрес, выровненный по странице. Диапазон сужается до целых страниц внутри него:
+    // крайние страницы могут принадлежать соседней панели или другим объектам кучи
+    const std::uintptr_t page = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    const std::uintptr_t first = (reinterpret_cast<std::uintptr_t>(data) + page - 1) / page * page;
+    const std::uintptr_t last = (reinterpret_cast<std::uintptr_t>(data) + bytes) / page * page;
+    if (first >= last) return true;
+    return syscall(SYS_mbind, first, last - first, mode, mask, MAX_NODES + 1, MPOL_MF_MOVE_FLAG) == 0;
+}
+#endif
+
+std::vector<int> allowedCpus() {
+    std::vector<int> cpus;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+        }
+    }
+#elif defined(_WIN32)
+    DWORD_PTR process = 0, system = 0;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &process, &system)) {
+        for (int cpu = 0; cpu < static_cast<int>(sizeof(DWORD_PTR) * 8); cpu++) {
+            if (process & (DWORD_PTR(1) << cpu)) cpus.push_back(cpu);
+        }
+    }
+#endif
+    return cpus;
+}
+
+NumaTopology detectTopology() {
+    const std::vector<int> allowed = allowedCpus();
+    NumaTopology topology;
+    auto addNode = [&](int id, const std::vector<int>& cpus) {
+        std::vector<int> usable;
+        for (int cpu : cpus) {
+            if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) usable.push_back(cpu);
+        }
+        if (usable.empty()) return;
+        std::sort(usable.begin(), usable.end());
+        topology.nodeIds.push_back(id);
+        topology.nodeCpus.push_back(usable);
+    };
+#if defined(__linux__)
+    try {
+        for (int node : parseCpuList(readLine("/sys/devices/system/node/online"))) {
+            addNode(node, parseCpuList(readLine("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist")));
+        }
+    }
+    catch (const std::exception&) {
+        topology = NumaTopology();
+    }
+#elif defined(_WIN32)
+    ULONG highest = 0;
+    if (GetNumaHighestNodeNumber(&highest)) {
+        for (ULONG node = 0; node <= highest; node++) {
+            ULONGLONG mask = 0;
+            if (!GetNumaNodeProcessorMask(static_cast<UCHAR>(node), &mask)) continue;
+            std::vector<int> cpus;
+            for (int cpu = 0; cpu < 64; cpu++) {
+                if (mask & (ULONGLONG(1) << cpu)) cpus.push_back(cpu);
+            }
+            addNode(static_cast<int>(node), cpus);
+        }
+    }
+#endif
+    if (topology.nodeIds.empty() && !allowed.empty()) {
+        topology.nodeIds.push_back(0);
+        topology.nodeCpus.push_back(allowed);
+    }
+    return topology;
+}
+
+} // namespace
+
+int NumaTopology::nodeOf(int cpu) const {
+    for (int node = 0; node < nodes(); node++) {
+        if (std::binary_search(nodeCpus[node].begin(), nodeCpus[node].end(), cpu)) return nodeIds[node];
+    }
+    return -1;
+}
+
+const NumaTopology& NumaTopology::system() {
+    static const NumaTopology topology = detectTopology();
+    return topology;
+}
+
+AffinityConfig parseAffinity(const std::string& value) {
+    AffinityConfig config;
+    if (value == "none") return config;
+    if (value == "compact") config.policy = AffinityPolicy::Compact;
+    else if (value == "spread") config.policy = AffinityPolicy::Spread;
+    else {
+        config.policy = AffinityPolicy::Explicit;
+        std::stringstream stream(value);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            std::size_t pos = 0;
+            int cpu = -1;
+            try {
+                cpu = std::stoi(item, &pos);
+            }
+            catch (const std::exception&) {
+                pos = 0;
+            }
+            if (pos != item.size() || cpu < 0) {
+                throw std::invalid_argument("Неизвестное правило закрепления потоков: " + value);
+            }
+            config.cpus.push_back(cpu);
+        }
+        if (config.cpus.empty()) {
+            throw std::invalid_argument("Неизвестное правило закрепления потоков: " + value);
+        }
+    }
+    return config;
+}
+
+std::string affinityName(const AffinityConfig& config) {
+    switch (config.policy) {
+    case AffinityPolicy::None: return "none";
+    case AffinityPolicy::Compact: return "compact";
+    case AffinityPolicy::Spread: return "spread";
+    default: break;
+    }
+    std::string name;
+    for (int cpu : config.cpus) name += (name.empty() ? "" : ",") + std::to_string(cpu);
+    return name;
+}
+
+std::vector<int> affinityPlan(const AffinityConfig& config, int threads) {
+    std::vector<int> plan;
+    if (config.policy == AffinityPolicy::None || threads <= 0) return plan;
+    const NumaTopology& topology = NumaTopology::system();
+
+    if (config.policy == AffinityPolicy::Explicit) {
+        if (config.cpus.empty()) {
+            throw std::invalid_argument("affinityPlan: не задан список ядер");
+        }
+        for (int cpu : config.cpus) {
+            if (topology.nodeOf(cpu) < 0) {
+                throw std::invalid_argument("affinityPlan: ядро " + std::to_string(cpu) + " недоступно процессу");
+            }
+        }
+        for (int t = 0; t < threads; t++) plan.push_back(config.cpus[t % config.cpus.size()]);
+        return plan;
+    }
+    if (topology.nodes() == 0) return plan;
+
+    if (config.policy == AffinityPolicy::Compact) {
+        std::vector<int> ordered;
+        for (const auto& cpus : topology.nodeCpus) ordered.insert(ordered.end(), cpus.begin(), cpus.end());
+        for (int t = 0; t < threads; t++) plan.push_back(ordered[t % ordered.size()]);
+        return plan;
+    }
+
+    // Spread: поток t - на узле t % nodes; потоки одного узла равномерно по его ядрам
+    const int nodes = topology.nodes();
+    for (int t = 0; t < threads; t++) {
+        const std::vector<int>& cpus = topology.nodeCpus[t % nodes];
+        const int onNode = (threads - t % nodes + nodes - 1) / nodes;
+        const int index = t / nodes;
+        plan.push_back(cpus[static_cast<std::size_t>(index) * cpus.size() / onNode % cpus.size()]);
+    }
+    return plan;
+}
+
+void pinCurrentThread(int cpu) {
+    if (cpu < 0) return;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#elif defined(_WIN32)
+    SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu);
+#endif
+}
+
+std::vector<int> currentThreadCpus() {
+    return allowedCpus();
+}
+
+SavedAffinity::SavedAffinity(SavedAffinity&& other) noexcept : cpus(std::move(other.cpus)), saved(other.saved) {
+    other.saved = false;
+}
+
+SavedAffinity& SavedAffinity::operator=(SavedAffinity&& other) noexcept {
+    if (this != &other) {
+        restore();
+        cpus = std::move(other.cpus);
+        saved = other.saved;
+        other.saved = false;
+    }
+    return *this;
+}
+
+SavedAffinity::~SavedAffinity() {
+    restore();
+}
+
+SavedAffinity SavedAffinity::capture() {
+    SavedAffinity result;
+    result.cpus = currentThreadCpus();
+    result.saved = !result.cpus.empty();
+    return result;
+}
+
+void SavedAffinity::restore() {
+    if (!saved) return;
+    saved = false;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#elif defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus) mask |= DWORD_PTR(1) << cpu;
+    SetThreadAffinityMask(GetCurrentThread(), mask);
+#endif
+}
+
+int currentNumaNode() {
+    return NumaTopology::system().nodeOf(currentCpu());
+}
+
+bool interleaveMemory(void* data, std::size_t bytes) {
+    const NumaTopology& topology = NumaTopology::system();
+    if (topology.nodes() <= 1) return true;
+#if defined(__linux__)
+    return mbindRange(data, bytes, MPOL_INTERLEAVE_MODE, topology.nodeIds);
+#else
+    (void)data;
+    (void)bytes;
+    return false;
+#endif
+}
+
+bool placeMemoryOnNode(void* data, std::size_t bytes, int node) {
+    if (NumaTopology::system().nodes() <= 1) return true;
+#if defined(__linux__)
+    return mbindRange(data, bytes, MPOL_PREFERRED_MODE, { node });
+#else
+    (void)data;
+    (void)bytes;
+    (void)node;
+    return false;
+#endif
+}
@@ -0,0 +1,96 @@
+#include "AsyncMultiply.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include "Kernels.h"
+
+MultiplyQueue::MultiplyQueue(int concurrency, int threadsPerProduct, int capacity)
+    : threadsPerProduct(threadsPerProduct), capacity(capacity) {
+    if (concurrency <= 0 || threadsPerProduct < 0 || capacity < 0) {
+        throw std::invalid_argument("MultiplyQueue: параллелизм должен быть положительным, "
+            "число потоков и ёмкость - неотрицательными");
+    }
+    if (this->threadsPerProduct == 0) {
+        this->threadsPerProduct = std::max(1, ThreadPool::shared().size() / concurrency);
+    }
+    for (int i = 0; i < concurrency; i++) {
+        dispatchers.emplace_back(&MultiplyQueue::run, this);
+    }
+}
+
+MultiplyQueue::~MultiplyQueue() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        ready.notify_all();
+    }
+    for (auto& dispatcher : dispatchers) {
+        dispatcher.join();
+    }
+}
+
+std::future<MultiplyResult> MultiplyQueue::submit(AlignedMatrix<int> A, AlignedMatrix<int> B) {
+    if (A.cols() != B.rows()) {
+        throw std::invalid_argument("MultiplyQueue::submit: число столбцов A не равно числу строк B");
+    }
+    Request request;
+    request.A = std::move(A);
+    request.B = std::move(B);
+    std::future<MultiplyResult> result = request.promise.get_future();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    space.wait(lock, [&] { return capacity == 0 || static_cast<int>(requests.size()) < capacity; });
+    request.submitted = std::chrono::high_resolution_clock::now();
+    requests.push_back(std::move(request));
+    ready.notify_one();
+    return result;
+}
+
+int MultiplyQueue::pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<int>(requests.size());
+}
+
+void MultiplyQueue::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [&] { return requests.empty() && running == 0; });
+}
+
+void MultiplyQueue::run() {
+    while (true) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&] { return stopping || !requests.empty(); });
+            // При остановке оставшиеся запросы всё равно выполняются: их future уже выданы
+            if (requests.empty()) return;
+            request = std::move(requests.front());
+            requests.pop_front();
+            running++;
+            space.notify_one();
+        }
+
+        try {
+            MultiplyResult result;
+            auto start = std::chrono::high_resolution_clock::now();
+            result.C = AlignedMatrix<int>::uninitialized(request.A.rows(), request.B.cols());
+            gemmKernel(Transpose::N, Transpose::N, 1, request.A.view(), request.B.view(), 0,
+                result.C.data(), result.C.ld(), BlockSizes(), threadsPerProduct, WORK_STEALING_SCHEDULE);
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> diff = end - start;
+            std::chrono::duration<double> queued = start - request.submitted;
+            result.seconds = diff.count();
+            result.queueSeconds = queued.count();
+            result.A = std::move(request.A);
+            result.B = std::move(request.B);
+            request.promise.set_value(std::move(result));
+        }
+        catch (...) {
+            request.promise.set_exception(std::current_exception());
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        running--;
+        if (requests.empty() && running == 0) idle.notify_all();
+    }
+}
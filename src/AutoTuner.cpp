@@ -0,0 +1,156 @@
+#include "AutoTuner.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <omp.h>
+#include "MicroKernels.h"
+#include "Random.h"
+
+namespace {
+
+// Наибольший размер пробной матрицы: для больших n настройка идёт на уменьшенной задаче
+constexpr int PROXY_MAX = 768;
+// Замеров на каждую пробную конфигурацию, берётся лучший
+constexpr int TRIALS = 2;
+
+const char* const SCHEDULES[] = { "static", "dynamic", "guided" };
+const int CHUNKS[] = { 0, 1, 4 };
+const BlockSizes TILE_CANDIDATES[] = { { 64, 512, 256 }, { 96, 1024, 256 }, { 48, 256, 128 } };
+
+double measure(MatrixView<int> A, MatrixView<int> B, AlignedMatrix<int>& C, const TuningConfig& config) {
+    double best = 0;
+    for (int t = 0; t < TRIALS; t++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        multiplyBlockedKernelParallel(A, B, C.data(), C.ld(), config.tiles, config.threads,
+            config.schedule, config.chunk);
+        std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+        if (t == 0 || diff.count() < best) best = diff.count();
+    }
+    return best;
+}
+
+} // namespace
+
+AutoTuner::AutoTuner(std::string cachePath) : path(std::move(cachePath)), cpu(cpuModelName()) {}
+
+AutoTuner& AutoTuner::instance() {
+    static AutoTuner tuner([] {
+        const char* env = std::getenv("MATRIX_TUNING_CACHE");
+        return std::string(env ? env : "matrix_tuning.cache");
+    }());
+    return tuner;
+}
+
+int AutoTuner::bucketOf(int n) {
+    int bucket = 0;
+    while (n > 1) {
+        n >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+int AutoTuner::tuningRuns() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return runs;
+}
+
+const std::string& AutoTuner::cachePath() const {
+    return path;
+}
+
+TuningConfig AutoTuner::configFor(int n) {
+    if (n <= 0) {
+        throw std::invalid_argument("AutoTuner: размер матрицы должен быть положительным");
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!loaded) {
+        load();
+        loaded = true;
+    }
+    const int bucket = bucketOf(n);
+    auto it = configs.find(bucket);
+    if (it != configs.end()) return it->second;
+
+    TuningConfig config = tune(n);
+    runs++;
+    configs[bucket] = config;
+    store(bucket, config);
+    return config;
+}
+
+TuningConfig AutoTuner::tune(int n) const {
+    const int size = std::min(n, PROXY_MAX);
+    AlignedMatrix<int> A(AlignedMatrix<int>::uninitialized(size, size));
+    AlignedMatrix<int> B(AlignedMatrix<int>::uninitialized(size, size));
+    AlignedMatrix<int> C(size, size);
+    fillRandom(A, size, 0, -100, 100);
+    fillRandom(B, size, 1, -100, 100);
+
+    const int procs = omp_get_num_procs();
+    std::vector<int> threadCandidates = { 1, procs / 2, procs };
+    std::sort(threadCandidates.begin(), threadCandidates.end());
+    threadCandidates.erase(std::unique(threadCandidates.begin(), threadCandidates.end()), threadCandidates.end());
+
+    TuningConfig best;
+    best.time = measure(A.view(), B.view(), C, best);
+    auto consider = [&](TuningConfig candidate) {
+        candidate.time = measure(A.view(), B.view(), C, candidate);
+        if (candidate.time < best.time) best = candidate;
+    };
+
+    for (int threads : threadCandidates) {
+        if (threads < 1 || threads == best.threads) continue;
+        TuningConfig candidate = best;
+        candidate.threads = threads;
+        consider(candidate);
+    }
+    for (const BlockSizes& tiles : TILE_CANDIDATES) {
+        TuningConfig candidate = best;
+        candidate.tiles = tiles;
+        consider(candidate);
+    }
+    for (const char* schedule : SCHEDULES) {
+        for (int chunk : CHUNKS) {
+            TuningConfig candidate = best;
+            candidate.schedule = schedule;
+            candidate.chunk = chunk;
+            consider(candidate);
+        }
+    }
+    return best;
+}
+
+// Формат строки кэша (через табуляцию):
+// модель процессора, корзина, потоки, tile_i, tile_j, tile_k, планировка, порция, время
+void AutoTuner::load() {
+    if (path.empty()) return;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::stringstream fields(line);
+        std::string model;
+        int bucket = 0;
+        TuningConfig config;
+        if (!std::getline(fields, model, '\t') || model != cpu) continue;
+        if (!(fields >> bucket >> config.threads >> config.tiles.tile_i >> config.tiles.tile_j
+            >> config.tiles.tile_k >> config.schedule >> config.chunk >> config.time)) continue;
+        // Повреждённые строки пропускаются, при повторах действует последняя
+        if (config.threads <= 0 || config.chunk < 0 || config.tiles.tile_i <= 0 || config.tiles.tile_j <= 0
+            || config.tiles.tile_k <= 0) continue;
+        if (config.schedule != "static" && config.schedule != "dynamic" && config.schedule != "guided") continue;
+        configs[bucket] = config;
+    }
+}
+
+void AutoTuner::store(int bucket, const TuningConfig& config) const {
+    if (path.empty()) return;
+    std::ofstream out(path, std::ios::app);
+    out << cpu << '\t' << bucket << '\t' << config.threads << '\t' << config.tiles.tile_i << '\t'
+        << config.tiles.tile_j << '\t' << config.tiles.tile_k << '\t' << config.schedule << '\t'
+        << config.chunk << '\t' << config.time << '\n';
+}
@@ -0,0 +1,336 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include "MicroKernels.h"
+#include "ThreadPool.h"
+
+namespace {
+
+std::vector<std::string> splitList(const std::string& value) {
+    std::vector<std::string> items;
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    if (items.empty()) {
+        throw std::invalid_argument("Пустой список значений: " + value);
+    }
+    return items;
+}
+
+// Одно целое число не меньше minimum; лишние символы и списки не допускаются
+int parseInt(const std::string& value, int minimum) {
+    std::size_t pos = 0;
+    int number = 0;
+    try {
+        number = std::stoi(value, &pos);
+    }
+    catch (const std::exception&) {
+        pos = 0;
+    }
+    if (pos == 0 || pos != value.size() || number < minimum) {
+        throw std::invalid_argument("Ожидалось целое число не меньше " + std::to_string(minimum) + ": " + value);
+    }
+    return number;
+}
+
+std::vector<int> splitIntList(const std::string& value) {
+    std::vector<int> numbers;
+    for (const auto& item : splitList(value)) {
+        numbers.push_back(parseInt(item, 1));
+    }
+    return numbers;
+}
+
+std::vector<double> splitDensityList(const std::string& value) {
+    std::vector<double> densities;
+    for (const auto& item : splitList(value)) {
+        std::size_t pos = 0;
+        double density = 0;
+        try {
+            density = std::stod(item, &pos);
+        }
+        catch (const std::exception&) {
+            pos = 0;
+        }
+        if (pos != item.size() || !(density > 0 && density <= 1)) {
+            throw std::invalid_argument("Ожидалась плотность в (0, 1]: " + item);
+        }
+        densities.push_back(density);
+    }
+    return densities;
+}
+
+const BenchmarkKernel& findKernel(const std::string& name) {
+    for (const auto& kernel : benchmarkKernels()) {
+        if (kernel.name == name) return kernel;
+    }
+    throw std::invalid_argument("Неизвестный вариант умножения: " + name);
+}
+
+std::string jsonEscape(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+// Фиксированный seed: разреженные B разных размеров и запусков воспроизводимы
+constexpr std::uint64_t SPARSE_SEED = 2024;
+
+std::string timestamp() {
+    std::time_t now = std::time(nullptr);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    return buffer;
+}
+
+// Среднее за замер: доступные счётчики суммы делятся на число замеров
+PerfCounts averageCounts(const PerfCounts& sum, int repetitions) {
+    PerfCounts average = sum;
+    for (long long* value : { &average.cycles, &average.instructions, &average.l1dMisses,
+        &average.llcMisses, &average.dtlbMisses }) {
+        if (*value >= 0) *value /= repetitions;
+    }
+    return average;
+}
+
+} // namespace
+
+const std::vector<BenchmarkKernel>& benchmarkKernels() {
+    static const std::vector<BenchmarkKernel> kernels = {
+        { "linear", false, false, false, [](Matrix& m, int, const std::string&) { return m.multiplyLinear(); } },
+        { "parallel", true, true, true, [](Matrix& m, int t, const std::string& s) { return m.multiplyParallel(t, s); } },
+        { "blocked", true, false, false, [](Matrix& m, int t, const std::string&) { return m.multiplyBlockedParallel(t); } },
+        { "pool", true, false, false, [](Matrix& m, int t, const std::string&) {
+            const BlockSizes tiles;
+            return m.multiplyBlockedParallel(t, tiles.tile_i, tiles.tile_j, tiles.tile_k, WORK_STEALING_SCHEDULE);
+        } },
+        { "strassen", true, false, false, [](Matrix& m, int t, const std::string&) { return m.multiplyStrassen(t); } },
+        { "int8", true, false, false, [](Matrix& m, int t, const std::string&) { return m.multiplyNarrow(t, ElementType::Int8); } },
+        { "int16", true, false, false, [](Matrix& m, int t, const std::string&) { return m.multiplyNarrow(t, ElementType::Int16); } },
+        { "auto", false, false, false, [](Matrix& m, int, const std::string&) { return m.multiplyAuto(); } },
+        { "sparse", true, false, false, [](Matrix& m, int t, const std::string&) { return m.multiplySparse(t); } },
+        { "spmm", true, false, false, [](Matrix& m, int t, const std::string&) { return m.multiplySparse(t, SparsePath::SparseB); } },
+    };
+    return kernels;
+}
+
+SampleStats computeStats(std::vector<double> samples) {
+    if (samples.empty()) {
+        throw std::invalid_argument("computeStats: нет замеров");
+    }
+    std::sort(samples.begin(), samples.end());
+    const std::size_t count = samples.size();
+    SampleStats stats;
+    stats.min = samples.front();
+    stats.median = count % 2 ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) / 2;
+    const std::size_t rank = static_cast<std::size_t>(std::ceil(0.95 * count));
+    stats.p95 = samples[std::max<std::size_t>(rank, 1) - 1];
+    double sum = 0;
+    for (double sample : samples) sum += sample;
+    stats.mean = sum / count;
+    return stats;
+}
+
+BenchmarkConfig parseBenchmarkArgs(int argc, char** argv) {
+    BenchmarkConfig config;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Не указано значение аргумента " + arg);
+        }
+        const std::string value = argv[++i];
+        if (arg == "--sizes") config.sizes = splitIntList(value);
+        else if (arg == "--threads") config.threads = splitIntList(value);
+        else if (arg == "--schedules") config.schedules = splitList(value);
+        else if (arg == "--kernels") config.kernels = splitList(value);
+        else if (arg == "--densities") config.densities = splitDensityList(value);
+        else if (arg == "--affinity") {
+            const bool numa = config.affinity.numaPlacement;
+            config.affinity = parseAffinity(value);
+            config.affinity.numaPlacement = numa;
+        }
+        else if (arg == "--numa") {
+            if (value != "on" && value != "off") {
+                throw std::invalid_argument("Ожидалось on или off: " + value);
+            }
+            config.affinity.numaPlacement = value == "on";
+        }
+        else if (arg == "--perf") {
+            if (value != "on" && value != "off") {
+                throw std::invalid_argument("Ожидалось on или off: " + value);
+            }
+            config.perfCounters = value == "on";
+        }
+        else if (arg == "--warmup") config.warmup = parseInt(value, 0);
+        else if (arg == "--reps") config.repetitions = parseInt(value, 1);
+        else if (arg == "--csv") config.csvPath = value;
+        else if (arg == "--json") config.jsonPath = value;
+        else throw std::invalid_argument("Неизвестный аргумент " + arg);
+    }
+    for (const auto& name : config.kernels) findKernel(name);
+    affinityPlan(config.affinity, 1);
+    for (const auto& schedule : config.schedules) {
+        if (schedule != "static" && schedule != "dynamic" && schedule != "guided" && schedule != WORK_STEALING_SCHEDULE) {
+            throw std::invalid_argument("Неизвестный тип планирования: " + schedule);
+        }
+    }
+    return config;
+}
+
+std::vector<BenchmarkResult> runBenchmark(const BenchmarkConfig& config, std::ostream* progress) {
+    std::vector<BenchmarkResult> results;
+
+    for (int size : config.sizes) {
+        for (double density : config.densities) {
+            Matrix matrix(size);
+            matrix.setAffinity(config.affinity);
+            matrix.enablePerfCounters(config.perfCounters);
+            if (density < 1) matrix.initialize(SPARSE_SEED, 1.0, density);
+            else matrix.initialize();
+
+            for (const auto& name : config.kernels) {
+                const BenchmarkKernel& kernel = findKernel(name);
+                const std::vector<int> threadCounts = kernel.usesThreads ? config.threads : std::vector<int>{ 1 };
+                const std::vector<std::string> schedules = kernel.usesSchedule ? config.schedules : std::vector<std::string>{ "-" };
+
+                for (int threads : threadCounts) {
+                    for (const auto& schedule : schedules) {
+                        if (progress) {
+                            *progress << "[" << size;
+                            if (density < 1) *progress << " d=" << density;
+                            *progress << "] " << name << " " << schedule << " x" << threads << std::endl;
+                        }
+                        for (int w = 0; w < config.warmup; w++) {
+                            kernel.run(matrix, threads, schedule);
+                        }
+                        BenchmarkResult result;
+                        result.size = size;
+                        result.density = density;
+                        result.kernel = name;
+                        result.schedule = schedule;
+                        result.threads = threads;
+                        double imbalanceSum = 0;
+                        PerfCounts countersSum;
+                        for (int r = 0; r < config.repetitions; r++) {
+                            result.samples.push_back(kernel.run(matrix, threads, schedule));
+                            if (kernel.reportsTelemetry) imbalanceSum += matrix.lastTelemetry().imbalance();
+                            countersSum += matrix.lastPerfCounters().total();
+                        }
+                        if (kernel.reportsTelemetry) result.imbalance = imbalanceSum / config.repetitions;
+                        result.counters = averageCounts(countersSum, config.repetitions);
+                        result.stats = computeStats(result.samples);
+                        result.gops = 2.0 * size * size * static_cast<double>(size) / result.stats.median / 1e9;
+                        results.push_back(result);
+                    }
+                }
+            }
+        }
+    }
+
+    // Ускорения считаются после всех замеров: базовые конфигурации могут идти в любом порядке
+    std::map<std::pair<int, double>, double> linearMedian;
+    std::map<std::tuple<int, double, std::string, std::string>, double> singleMedian;
+    for (const auto& r : results) {
+        if (r.kernel == "linear") linearMedian[std::make_pair(r.size, r.density)] = r.stats.median;
+        if (r.threads == 1) singleMedian[std::make_tuple(r.size, r.density, r.kernel, r.schedule)] = r.stats.median;
+    }
+    for (auto& r : results) {
+        auto linear = linearMedian.find(std::make_pair(r.size, r.density));
+        if (linear != linearMedian.end()) r.speedupLinear = linear->second / r.stats.median;
+        auto single = singleMedian.find(std::make_tuple(r.size, r.density, r.kernel, r.schedule));
+        if (single != singleMedian.end()) r.speedupSingle = single->second / r.stats.median;
+    }
+    return results;
+}
+
+void writeCsv(std::ostream& out, const std::vector<BenchmarkResult>& results) {
+    out << "size,kernel,schedule,threads,repetitions,min_s,median_s,p95_s,mean_s,gops,speedup_vs_linear,speedup_vs_1thread,imbalance,density,"
+        "cycles,instructions,ipc,l1d_misses,llc_misses,dtlb_misses\n";
+    out << std::setprecision(9);
+    for (const auto& r : results) {
+        out << r.size << ',' << r.kernel << ',' << r.schedule << ',' << r.threads << ',' << r.samples.size() << ','
+            << r.stats.min << ',' << r.stats.median << ',' << r.stats.p95 << ',' << r.stats.mean << ','
+            << r.gops << ',' << r.speedupLinear << ',' << r.speedupSingle << ',' << r.imbalance << ',' << r.density << ','
+            << r.counters.cycles << ',' << r.counters.instructions << ',' << r.counters.ipc() << ','
+            << r.counters.l1dMisses << ',' << r.counters.llcMisses << ',' << r.counters.dtlbMisses << '\n';
+    }
+}
+
+void writeJson(std::ostream& out, const std::vector<BenchmarkResult>& results) {
+    out << std::setprecision(9);
+    out << "{\n  \"timestamp\": \"" << timestamp() << "\",\n"
+        << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n"
+        << "  \"micro_kernel\": \"" << jsonEscape(activeMicroKernel().name) << "\",\n"
+#ifdef __VERSION__
+        << "  \"compiler\": \"" << jsonEscape(__VERSION__) << "\",\n"
+#endif
+        << "  \"results\": [";
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        out << (i ? "," : "") << "\n    {\"size\": " << r.size << ", \"density\": " << r.density << ", \"kernel\": \"" << jsonEscape(r.kernel)
+            << "\", \"schedule\": \"" << jsonEscape(r.schedule) << "\", \"threads\": " << r.threads
+            << ", \"min_s\": " << r.stats.min << ", \"median_s\": " << r.stats.median
+            << ", \"p95_s\": " << r.stats.p95 << ", \"mean_s\": " << r.stats.mean << ", \"gops\": " << r.gops
+            << ", \"speedup_vs_linear\": " << r.speedupLinear << ", \"speedup_vs_1thread\": " << r.speedupSingle
+            << ", \"imbalance\": " << r.imbalance;
+        if (r.counters.available()) {
+            out << ", \"counters\": {\"cycles\": " << r.counters.cycles << ", \"instructions\": " << r.counters.instructions
+                << ", \"ipc\": " << r.counters.ipc() << ", \"l1d_misses\": " << r.counters.l1dMisses
+                << ", \"llc_misses\": " << r.counters.llcMisses << ", \"dtlb_misses\": " << r.counters.dtlbMisses << "}";
+        }
+        out << ", \"samples\": [";
+        for (std::size_t s = 0; s < r.samples.size(); s++) {
+            out << (s ? ", " : "") << r.samples[s];
+        }
+        out << "]}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void printTable(std::ostream& out, const std::vector<BenchmarkResult>& results) {
+    out << std::left << std::setw(7) << "size" << std::setw(9) << "density" << std::setw(10) << "kernel" << std::setw(9) << "schedule"
+        << std::setw(8) << "threads" << std::right << std::setw(12) << "min_s" << std::setw(12) << "median_s"
+        << std::setw(12) << "p95_s" << std::setw(10) << "GOP/s" << std::setw(10) << "x_linear" << std::setw(10)
+        << "x_1thread" << std::setw(11) << "imbalance" << '\n';
+    out << std::fixed;
+    for (const auto& r : results) {
+        out << std::left << std::setw(7) << r.size << std::setprecision(4) << std::setw(9) << r.density
+            << std::setw(10) << r.kernel << std::setw(9) << r.schedule
+            << std::setw(8) << r.threads << std::right << std::setprecision(5) << std::setw(12) << r.stats.min
+            << std::setw(12) << r.stats.median << std::setw(12) << r.stats.p95 << std::setprecision(2)
+            << std::setw(10) << r.gops << std::setw(10) << r.speedupLinear << std::setw(10) << r.speedupSingle
+            << std::setw(11) << r.imbalance << '\n';
+    }
+
+    // Счётчики - отдельной таблицей, чтобы основная не расширялась, когда их нет
+    const bool counters = std::any_of(results.begin(), results.end(),
+        [](const BenchmarkResult& r) { return r.counters.available(); });
+    if (counters) {
+        out << '\n' << std::left << std::setw(7) << "size" << std::setw(9) << "density" << std::setw(10) << "kernel"
+            << std::setw(9) << "schedule" << std::setw(8) << "threads" << std::right << std::setw(14) << "cycles"
+            << std::setw(14) << "instructions" << std::setw(7) << "IPC" << std::setw(12) << "L1d_miss"
+            << std::setw(12) << "LLC_miss" << std::setw(12) << "dTLB_miss" << '\n';
+        for (const auto& r : results) {
+            out << std::left << std::setw(7) << r.size << std::setprecision(4) << std::setw(9) << r.density
+                << std::setw(10) << r.kernel << std::setw(9) << r.schedule << std::setw(8) << r.threads << std::right
+                << std::setw(14) << r.counters.cycles << std::setw(14) << r.counters.instructions
+                << std::setprecision(2) << std::setw(7) << r.counters.ipc() << std::setw(12) << r.counters.l1dMisses
+                << std::setw(12) << r.counters.llcMisses << std::setw(12) << r.counters.dtlbMisses << '\n';
+        }
+    }
+    out.unsetf(std::ios::fixed);
+}
@@ -0,0 +1,196 @@
+#include "Chain.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include "Kernels.h"
+
+namespace {
+
+// Операнд шага: исходная матрица цепочки (leaf >= 0) или промежуточный буфер slot
+struct Operand {
+    int leaf = -1;
+    int slot = -1;
+    int rows = 0;
+    int cols = 0;
+};
+
+// Шаг умножения: out - номер буфера, -1 - результат
+struct Step {
+    Operand left;
+    Operand right;
+    int out;
+};
+
+// Наибольшие размеры произведений, которые пишутся в буфер: буфер выделяется как матрица
+// rows x cols, и каждое из них занимает её левый верхний угол с шагом строки буфера
+struct Extent {
+    int rows = 0;
+    int cols = 0;
+};
+
+// Шаги для произведения A_i..A_j в порядке выполнения. Буфер результата шага выбирается до
+// освобождения буферов его операндов, так как ядро читает их, пока пишет результат
+Operand schedule(const ChainPlan& plan, int i, int j, bool root, std::vector<Step>& steps,
+    std::vector<int>& freeSlots, std::vector<Extent>& extents) {
+    if (i == j) {
+        return { i, -1, plan.dims[i], plan.dims[i + 1] };
+    }
+    const int s = plan.split[i][j];
+    const Operand left = schedule(plan, i, s, false, steps, freeSlots, extents);
+    const Operand right = schedule(plan, s + 1, j, false, steps, freeSlots, extents);
+    const int rows = plan.dims[i];
+    const int cols = plan.dims[j + 1];
+
+    int out = -1;
+    if (!root) {
+        if (freeSlots.empty()) {
+            out = static_cast<int>(extents.size());
+            extents.emplace_back();
+        }
+        else {
+            out = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        extents[out].rows = std::max(extents[out].rows, rows);
+        extents[out].cols = std::max(extents[out].cols, cols);
+    }
+    if (left.slot >= 0) freeSlots.push_back(left.slot);
+    if (right.slot >= 0) freeSlots.push_back(right.slot);
+    steps.push_back({ left, right, out });
+    return { -1, out, rows, cols };
+}
+
+std::string orderOf(const ChainPlan& plan, int i, int j) {
+    if (i == j) return "A" + std::to_string(i + 1);
+    const int s = plan.split[i][j];
+    return "(" + orderOf(plan, i, s) + orderOf(plan, s + 1, j) + ")";
+}
+
+// Владеющая копия представления со стандартным шагом строки
+AlignedMatrix<int> copyOf(MatrixView<int> view) {
+    return AlignedMatrix<int>(AlignedMatrix<int>::adopt(const_cast<int*>(view.data()), view.rows(),
+        view.cols(), view.ld()));
+}
+
+void multiplyInto(MatrixView<int> A, MatrixView<int> B, AlignedMatrix<int>& C, int num_threads) {
+    gemmKernel(Transpose::N, Transpose::N, 1, A, B, 0, C.data(), C.ld(), BlockSizes(), num_threads);
+}
+
+} // namespace
+
+std::string ChainPlan::order() const {
+    if (length() <= 0) return "";
+    const std::string text = orderOf(*this, 0, length() - 1);
+    // Внешние скобки всего произведения опускаются
+    return length() > 1 ? text.substr(1, text.size() - 2) : text;
+}
+
+ChainPlan planChain(const std::vector<int>& dims) {
+    if (dims.size() < 2) {
+        throw std::invalid_argument("planChain: в цепочке нет матриц");
+    }
+    if (std::any_of(dims.begin(), dims.end(), [](int d) { return d < 0; })) {
+        throw std::invalid_argument("planChain: размер матрицы не может быть отрицательным");
+    }
+    ChainPlan plan;
+    plan.dims = dims;
+    const int count = plan.length();
+    std::vector<std::vector<long long>> cost(count, std::vector<long long>(count, 0));
+    plan.split.assign(count, std::vector<int>(count, 0));
+
+    // cost[i][j] - наименьшее число умножений элементов для A_i..A_j, по возрастанию длины
+    for (int len = 2; len <= count; len++) {
+        for (int i = 0; i + len - 1 < count; i++) {
+            const int j = i + len - 1;
+            cost[i][j] = std::numeric_limits<long long>::max();
+            for (int s = i; s < j; s++) {
+                const long long candidate = cost[i][s] + cost[s + 1][j]
+                    + static_cast<long long>(dims[i]) * dims[s + 1] * dims[j + 1];
+                if (candidate < cost[i][j]) {
+                    cost[i][j] = candidate;
+                    plan.split[i][j] = s;
+                }
+            }
+        }
+    }
+    plan.cost = cost[0][count - 1];
+    return plan;
+}
+
+AlignedMatrix<int> multiplyChain(const std::vector<MatrixView<int>>& chain, int num_threads) {
+    if (chain.empty()) {
+        throw std::invalid_argument("multiplyChain: в цепочке нет матриц");
+    }
+    std::vector<int> dims = { chain.front().rows() };
+    for (std::size_t i = 0; i < chain.size(); i++) {
+        if (chain[i].rows() != dims.back()) {
+            throw std::invalid_argument("multiplyChain: число столбцов матрицы " + std::to_string(i)
+                + " не равно числу строк следующей");
+        }
+        dims.push_back(chain[i].cols());
+    }
+    if (chain.size() == 1) return copyOf(chain.front());
+
+    const ChainPlan plan = planChain(dims);
+    std::vector<Step> steps;
+    std::vector<int> freeSlots;
+    std::vector<Extent> extents;
+    schedule(plan, 0, plan.length() - 1, true, steps, freeSlots, extents);
+
+    // Все буферы выделяются до первого шага
+    std::vector<AlignedMatrix<int>> slots;
+    for (const Extent& extent : extents) {
+        slots.push_back(AlignedMatrix<int>::uninitialized(extent.rows, extent.cols));
+    }
+    AlignedMatrix<int> result = AlignedMatrix<int>::uninitialized(dims.front(), dims.back());
+
+    auto view = [&](const Operand& operand) {
+        if (operand.leaf >= 0) return chain[operand.leaf];
+        return slots[operand.slot].view().block(0, 0, operand.rows, operand.cols);
+    };
+    for (const Step& step : steps) {
+        const MatrixView<int> A = view(step.left);
+        const MatrixView<int> B = view(step.right);
+        if (step.out < 0) {
+            multiplyInto(A, B, result, num_threads);
+            continue;
+        }
+        AlignedMatrix<int> out = AlignedMatrix<int>::adopt(slots[step.out].data(), A.rows(), B.cols(),
+            slots[step.out].ld());
+        multiplyInto(A, B, out, num_threads);
+    }
+    return result;
+}
+
+AlignedMatrix<int> matrixPower(MatrixView<int> A, int exponent, int num_threads) {
+    if (A.rows() != A.cols()) {
+        throw std::invalid_argument("matrixPower: матрица не квадратная");
+    }
+    if (exponent < 0) {
+        throw std::invalid_argument("matrixPower: отрицательный показатель");
+    }
+    const int n = A.rows();
+    if (exponent == 0) {
+        AlignedMatrix<int> identity(n, n);
+        for (int i = 0; i < n; i++) identity.row(i)[i] = 1;
+        return identity;
+    }
+    if (exponent == 1) return copyOf(A);
+
+    AlignedMatrix<int> buffers[2] = { AlignedMatrix<int>::uninitialized(n, n), AlignedMatrix<int>::uninitialized(n, n) };
+    MatrixView<int> current = A;
+    int target = 0;
+    int top = 0;
+    while ((exponent >> (top + 1)) != 0) top++;
+    for (int bit = top - 1; bit >= 0; bit--) {
+        multiplyInto(current, current, buffers[target], num_threads);
+        current = buffers[target].view();
+        target ^= 1;
+        if ((exponent >> bit) & 1) {
+            multiplyInto(current, A, buffers[target], num_threads);
+            current = buffers[target].view();
+            target ^= 1;
+        }
+    }
+    return std::move(buffers[target ^ 1]);
+}
@@ -0,0 +1,100 @@
+#include "Expression.h"
+#include <omp.h>
+
+namespace {
+
+// Ширина полосы сумм, накапливаемых одним потоком при построчном чтении хранимой матрицы
+constexpr int TOTALS_BAND = 256;
+
+std::vector<long long> columnTotals(MatrixView<int> X, Transpose op, int num_threads);
+
+// Суммы строк op(X) в long long
+std::vector<long long> rowTotals(MatrixView<int> X, Transpose op, int num_threads) {
+    if (op == Transpose::T) return columnTotals(X, Transpose::N, num_threads);
+    std::vector<long long> totals(X.rows(), 0);
+    #pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (int i = 0; i < X.rows(); i++) {
+        const int* row = X.row(i);
+        long long sum = 0;
+        #pragma omp simd reduction(+ : sum)
+        for (int j = 0; j < X.cols(); j++) sum += row[j];
+        totals[i] = sum;
+    }
+    return totals;
+}
+
+// Суммы столбцов op(X) в long long
+std::vector<long long> columnTotals(MatrixView<int> X, Transpose op, int num_threads) {
+    if (op == Transpose::T) return rowTotals(X, Transpose::N, num_threads);
+    // Строки хранимой X читаются подряд; столбцы делятся между потоками полосами
+    std::vector<long long> totals(X.cols(), 0);
+    #pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (int j0 = 0; j0 < X.cols(); j0 += TOTALS_BAND) {
+        const int j1 = std::min(X.cols(), j0 + TOTALS_BAND);
+        for (int i = 0; i < X.rows(); i++) {
+            const int* row = X.row(i);
+            #pragma omp simd
+            for (int j = j0; j < j1; j++) totals[j] += row[j];
+        }
+    }
+    return totals;
+}
+
+} // namespace
+
+std::vector<long long> exactRowSums(const ProductExpr& e, int num_threads) {
+    expr_detail::checkThreads("exactRowSums", num_threads);
+    const std::vector<long long> ones = rowTotals(e.B, e.opB, num_threads);
+    const int k = static_cast<int>(ones.size());
+    std::vector<long long> sums(e.rows(), 0);
+    if (e.opA == Transpose::N) {
+        #pragma omp parallel for num_threads(num_threads) schedule(static)
+        for (int i = 0; i < e.rows(); i++) {
+            const int* row = e.A.row(i);
+            long long sum = 0;
+            #pragma omp simd reduction(+ : sum)
+            for (int p = 0; p < k; p++) sum += row[p] * ones[p];
+            sums[i] = sum;
+        }
+    }
+    else {
+        // op(A) = A^T: строка p хранимой A добавляет A(p, i) * ones[p] к суммам полосы
+        #pragma omp parallel for num_threads(num_threads) schedule(static)
+        for (int i0 = 0; i0 < e.rows(); i0 += TOTALS_BAND) {
+            const int i1 = std::min(e.rows(), i0 + TOTALS_BAND);
+            for (int p = 0; p < k; p++) {
+                const int* row = e.A.row(p);
+                #pragma omp simd
+                for (int i = i0; i < i1; i++) sums[i] += row[i] * ones[p];
+            }
+        }
+    }
+    return sums;
+}
+
+std::vector<long long> exactColumnSums(const ProductExpr& e, int num_threads) {
+    expr_detail::checkThreads("exactColumnSums", num_threads);
+    // (1^T * op(A)) * op(B) = (op(B)^T * (op(A)^T * 1))^T - суммы строк транспонированного произведения
+    const ProductExpr transposed = { e.B, e.A, e.opB == Transpose::N ? Transpose::T : Transpose::N,
+        e.opA == Transpose::N ? Transpose::T : Transpose::N };
+    return exactRowSums(transposed, num_threads);
+}
+
+long long exactSum(const ProductExpr& e, int num_threads) {
+    expr_detail::checkThreads("exactSum", num_threads);
+    const std::vector<long long> left = columnTotals(e.A, e.opA, num_threads);
+    const std::vector<long long> right = rowTotals(e.B, e.opB, num_threads);
+    long long total = 0;
+    for (std::size_t p = 0; p < left.size(); p++) total += left[p] * right[p];
+    return total;
+}
+
+ProductExpr product(MatrixView<int> A, MatrixView<int> B, Transpose opA, Transpose opB) {
+    ProductExpr e = { A, B, opA, opB };
+    const int k = opA == Transpose::N ? A.cols() : A.rows();
+    const int kb = opB == Transpose::N ? B.rows() : B.cols();
+    if (k != kb) {
+        throw std::invalid_argument("product: число столбцов op(A) не равно числу строк op(B)");
+    }
+    return e;
+}
@@ -0,0 +1,376 @@
+#include "Kernels.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include <omp.h>
+#include "MicroKernels.h"
+#include "ThreadPool.h"
+
+namespace {
+
+// Наибольший блок среди микроядер (AVX-512: 8 x 32)
+constexpr int MAX_MICRO_TILE = 8 * 32;
+
+void checkTiles(const BlockSizes& tiles) {
+    if (tiles.tile_i <= 0 || tiles.tile_j <= 0 || tiles.tile_k <= 0) {
+        throw std::invalid_argument("multiplyBlockedKernel: размеры блоков должны быть положительными");
+    }
+}
+
+void checkOperands(MatrixView<int> A, MatrixView<int> B, const BlockSizes& tiles) {
+    if (A.cols() != B.rows()) {
+        throw std::invalid_argument("multiplyBlockedKernel: число столбцов A не равно числу строк B");
+    }
+    checkTiles(tiles);
+}
+
+void zeroResult(int* C, std::ptrdiff_t ldc, int m, int n) {
+    for (int i = 0; i < m; i++) {
+        std::fill(C + i * ldc, C + i * ldc + n, 0);
+    }
+}
+
+// C = beta * C для строки длины n; beta = 0 записывает нули, не читая C
+void scaleRow(int* c, int n, int beta) {
+    if (beta == 0) {
+        std::fill(c, c + n, 0);
+    }
+    else if (beta != 1) {
+        #pragma omp simd
+        for (int j = 0; j < n; j++) {
+            c[j] *= beta;
+        }
+    }
+}
+
+int roundUp(int value, int multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+// Буфер не меньше rows x cols; при нехватке выделяется заново без заполнения (упаковка
+// записывает все элементы, включая дополнение нулями)
+void reserve(AlignedMatrix<int>& buffer, int rows, int cols) {
+    if (buffer.rows() < rows || buffer.cols() < cols) {
+        buffer = AlignedMatrix<int>::uninitialized(std::max(buffer.rows(), rows), std::max(buffer.cols(), cols));
+    }
+}
+
+// Упаковка блока A[i0:i0+mc, p0:p0+kc] полосами по mr строк: внутри полосы mr элементов
+// одного столбца лежат подряд, неполная последняя полоса дополняется нулями
+void packA(MatrixView<int> A, int i0, int p0, int mc, int kc, int mr, int* dst) {
+    for (int ir = 0; ir < mc; ir += mr) {
+        const int rows = std::min(mr, mc - ir);
+        int* sliver = dst + static_cast<std::ptrdiff_t>(ir) * kc;
+        for (int p = 0; p < kc; p++) {
+            for (int r = 0; r < rows; r++) {
+                sliver[p * mr + r] = A(i0 + ir + r, p0 + p);
+            }
+            for (int r = rows; r < mr; r++) {
+                sliver[p * mr + r] = 0;
+            }
+        }
+    }
+}
+
+// То же для op(A) с множителем alpha. При A^T столбец op(A) - это строка хранимой A,
+// поэтому mr элементов полосы копируются подряд из одной строки
+void packAScaled(MatrixView<int> A, Transpose op, int alpha, int i0, int p0, int mc, int kc, int mr, int* dst) {
+    for (int ir = 0; ir < mc; ir += mr) {
+        const int rows = std::min(mr, mc - ir);
+        int* sliver = dst + static_cast<std::ptrdiff_t>(ir) * kc;
+        for (int p = 0; p < kc; p++) {
+            int* column = sliver + p * mr;
+            if (op == Transpose::T) {
+                const int* src = A.row(p0 + p) + i0 + ir;
+                for (int r = 0; r < rows; r++) {
+                    column[r] = alpha * src[r];
+                }
+            }
+            else {
+                for (int r = 0; r < rows; r++) {
+                    column[r] = alpha * A(i0 + ir + r, p0 + p);
+                }
+            }
+            std::fill(column + rows, column + mr, 0);
+        }
+    }
+}
+
+// Упаковка строки p0+p панели B[p0:p0+kc, j0:j0+nc] в полосы по nr столбцов: внутри полосы
+// строки длины nr лежат подряд, неполная последняя полоса дополняется нулями
+void packBRow(MatrixView<int> B, int p0, int j0, int p, int nc, int kc, int nr, int* dst) {
+    const int* src = B.row(p0 + p) + j0;
+    for (int jr = 0; jr < nc; jr += nr) {
+        const int cols = std::min(nr, nc - jr);
+        int* row = dst + static_cast<std::ptrdiff_t>(jr) * kc + p * nr;
+        std::copy(src + jr, src + jr + cols, row);
+        std::fill(row + cols, row + nr, 0);
+    }
+}
+
+// Упаковка столбца j0+j панели op(B) = B^T[p0:p0+kc, j0:j0+nc]: это строка хранимой B,
+// она читается подряд и раскладывается в свою полосу с шагом nr. Столбцы j >= nc дополняют
+// последнюю полосу нулями
+void packBTransposedColumn(MatrixView<int> B, int p0, int j0, int j, int nc, int kc, int nr, int* dst) {
+    int* column = dst + static_cast<std::ptrdiff_t>(j / nr * nr) * kc + j % nr;
+    if (j >= nc) {
+        for (int p = 0; p < kc; p++) column[p * nr] = 0;
+        return;
+    }
+    const int* src = B.row(j0 + j) + p0;
+    for (int p = 0; p < kc; p++) {
+        column[p * nr] = src[p];
+    }
+}
+
+// Обход упакованного блока A (mc x kc) и панели B (kc x nc) микроядром. Полоса B остаётся
+// в L1 на время прохода по всем полосам A; краевые блоки считаются во временный буфер.
+void macroKernel(const MicroKernel& kernel, const int* Ap, const int* Bp, int mc, int nc, int kc,
+    int* C, std::ptrdiff_t ldc, bool accumulate) {
+    alignas(MATRIX_ALIGNMENT) int edge[MAX_MICRO_TILE];
+    for (int jr = 0; jr < nc; jr += kernel.nr) {
+        const int cols = std::min(kernel.nr, nc - jr);
+        const int* b = Bp + static_cast<std::ptrdiff_t>(jr) * kc;
+        for (int ir = 0; ir < mc; ir += kernel.mr) {
+            const int rows = std::min(kernel.mr, mc - ir);
+            const int* a = Ap + static_cast<std::ptrdiff_t>(ir) * kc;
+            int* c = C + ir * ldc + jr;
+            if (rows == kernel.mr && cols == kernel.nr) {
+                kernel.compute(kc, a, b, c, ldc, accumulate);
+                continue;
+            }
+            kernel.compute(kc, a, b, edge, kernel.nr, false);
+            for (int r = 0; r < rows; r++) {
+                for (int j = 0; j < cols; j++) {
+                    c[r * ldc + j] = accumulate ? c[r * ldc + j] + edge[r * kernel.nr + j] : edge[r * kernel.nr + j];
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+void multiplyBlockedKernel(MatrixView<int> A, MatrixView<int> B, int* C, std::ptrdiff_t ldc,
+    const BlockSizes& tiles) {
+    PackingBuffers buffers;
+    multiplyBlockedKernel(A, B, C, ldc, tiles, buffers);
+}
+
+void multiplyBlockedKernel(MatrixView<int> A, MatrixView<int> B, int* C, std::ptrdiff_t ldc,
+    const BlockSizes& tiles, PackingBuffers& buffers) {
+    checkOperands(A, B, tiles);
+    const int m = A.rows(), n = B.cols(), k = A.cols();
+    if (k == 0) {
+        zeroResult(C, ldc, m, n);
+        return;
+    }
+
+    const MicroKernel& kernel = activeMicroKernel();
+    reserve(buffers.A, roundUp(std::min(tiles.tile_i, m), kernel.mr), std::min(tiles.tile_k, k));
+    reserve(buffers.B, roundUp(std::min(tiles.tile_j, n), kernel.nr), std::min(tiles.tile_k, k));
+    int* Ap = buffers.A.data();
+    int* Bp = buffers.B.data();
+
+    for (int jc = 0; jc < n; jc += tiles.tile_j) {
+        const int nc = std::min(tiles.tile_j, n - jc);
+        for (int pc = 0; pc < k; pc += tiles.tile_k) {
+            const int kc = std::min(tiles.tile_k, k - pc);
+            for (int p = 0; p < kc; p++) {
+                packBRow(B, pc, jc, p, nc, kc, kernel.nr, Bp);
+            }
+            for (int ic = 0; ic < m; ic += tiles.tile_i) {
+                const int mc = std::min(tiles.tile_i, m - ic);
+                packA(A, ic, pc, mc, kc, kernel.mr, Ap);
+                macroKernel(kernel, Ap, Bp, mc, nc, kc, C + ic * ldc + jc, ldc, pc > 0);
+            }
+        }
+    }
+}
+
+void setRuntimeSchedule(const std::string& type, int chunk) {
+    if (chunk < 0) {
+        throw std::invalid_argument("Размер порции не может быть отрицательным");
+    }
+    if (type == "static") omp_set_schedule(omp_sched_static, chunk);
+    else if (type == "dynamic") omp_set_schedule(omp_sched_dynamic, chunk);
+    else if (type == "guided") omp_set_schedule(omp_sched_guided, chunk);
+    else throw std::invalid_argument("Неизвестный тип планирования: " + type);
+}
+
+void multiplyBlockedKernelParallel(MatrixView<int> A, MatrixView<int> B, int* C, std::ptrdiff_t ldc,
+    const BlockSizes& tiles, int num_threads, const std::string& type, int chunk) {
+    checkOperands(A, B, tiles);
+    gemmKernel(Transpose::N, Transpose::N, 1, A, B, 0, C, ldc, tiles, num_threads, type, chunk);
+}
+
+void gemmKernel(Transpose opA, Transpose opB, int alpha, MatrixView<int> A, MatrixView<int> B, int beta,
+    int* C, std::ptrdiff_t ldc, const BlockSizes& tiles, int num_threads, const std::string& type, int chunk) {
+    const int m = opA == Transpose::N ? A.rows() : A.cols();
+    const int k = opA == Transpose::N ? A.cols() : A.rows();
+    const int kb = opB == Transpose::N ? B.rows() : B.cols();
+    const int n = opB == Transpose::N ? B.cols() : B.rows();
+    if (k != kb) {
+        throw std::invalid_argument("gemmKernel: число столбцов op(A) не равно числу строк op(B)");
+    }
+    checkTiles(tiles);
+    const bool stealing = type == WORK_STEALING_SCHEDULE;
+    if (!stealing) setRuntimeSchedule(type, chunk);
+    if (k == 0 || alpha == 0) {
+        for (int i = 0; i < m; i++) scaleRow(C + i * ldc, n, beta);
+        return;
+    }
+
+    if (stealing) {
+        // Плитки C независимы: каждая считается одним потоком пула целиком по k. Упакованные
+        // панели принадлежат потоку пула и выделяются им при первой плитке, а не на каждую плитку
+        const MicroKernel& kernel = activeMicroKernel();
+        ThreadPool& pool = ThreadPool::shared();
+        std::vector<AlignedMatrix<int>> packedA(pool.size()), packedB(pool.size());
+        pool.parallelFor2D(m, n, tiles.tile_i, tiles.tile_j, num_threads,
+            [&](int worker, int i0, int i1, int j0, int j1) {
+                const int mc = i1 - i0;
+                const int nc = j1 - j0;
+                AlignedMatrix<int>& Ap = packedA[worker];
+                AlignedMatrix<int>& Bp = packedB[worker];
+                if (Ap.empty()) {
+                    Ap = AlignedMatrix<int>::uninitialized(roundUp(std::min(tiles.tile_i, m), kernel.mr),
+                        std::min(tiles.tile_k, k));
+                    Bp = AlignedMatrix<int>::uninitialized(roundUp(std::min(tiles.tile_j, n), kernel.nr),
+                        std::min(tiles.tile_k, k));
+                }
+                int* c = C + i0 * ldc + j0;
+                if (beta != 0) {
+                    for (int i = 0; i < mc; i++) scaleRow(c + i * ldc, nc, beta);
+                }
+                for (int pc = 0; pc < k; pc += tiles.tile_k) {
+                    const int kc = std::min(tiles.tile_k, k - pc);
+                    if (opB == Transpose::N) {
+                        for (int p = 0; p < kc; p++) packBRow(B, pc, j0, p, nc, kc, kernel.nr, Bp.data());
+                    }
+                    else {
+                        for (int j = 0; j < roundUp(nc, kernel.nr); j++) {
+                            packBTransposedColumn(B, pc, j0, j, nc, kc, kernel.nr, Bp.data());
+                        }
+                    }
+                    packAScaled(A, opA, alpha, i0, pc, mc, kc, kernel.mr, Ap.data());
+                    macroKernel(kernel, Ap.data(), Bp.data(), mc, nc, kc, c, ldc, beta != 0 || pc > 0);
+                }
+            });
+        return;
+    }
+
+    const MicroKernel& kernel = activeMicroKernel();
+    const int blocks_i = (m + tiles.tile_i - 1) / tiles.tile_i;
+    AlignedMatrix<int> Bp(roundUp(std::min(tiles.tile_j, n), kernel.nr), std::min(tiles.tile_k, k));
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        AlignedMatrix<int> Ap(roundUp(std::min(tiles.tile_i, m), kernel.mr), std::min(tiles.tile_k, k));
+
+        // При beta = 0 первый проход по k перезаписывает C, иначе C заранее масштабируется
+        if (beta != 0) {
+            #pragma omp for schedule(static)
+            for (int i = 0; i < m; i++) {
+                scaleRow(C + i * ldc, n, beta);
+            }
+        }
+
+        for (int jc = 0; jc < n; jc += tiles.tile_j) {
+            const int nc = std::min(tiles.tile_j, n - jc);
+            for (int pc = 0; pc < k; pc += tiles.tile_k) {
+                const int kc = std::min(tiles.tile_k, k - pc);
+
+                // Панель B общая для всех потоков: упаковываем её совместно
+                if (opB == Transpose::N) {
+                    #pragma omp for schedule(static)
+                    for (int p = 0; p < kc; p++) {
+                        packBRow(B, pc, jc, p, nc, kc, kernel.nr, Bp.data());
+                    }
+                }
+                else {
+                    #pragma omp for schedule(static)
+                    for (int j = 0; j < roundUp(nc, kernel.nr); j++) {
+                        packBTransposedColumn(B, pc, jc, j, nc, kc, kernel.nr, Bp.data());
+                    }
+                }
+
+                #pragma omp for schedule(runtime)
+                for (int bi = 0; bi < blocks_i; bi++) {
+                    const int ic = bi * tiles.tile_i;
+                    const int mc = std::min(tiles.tile_i, m - ic);
+                    packAScaled(A, opA, alpha, ic, pc, mc, kc, kernel.mr, Ap.data());
+                    macroKernel(kernel, Ap.data(), Bp.data(), mc, nc, kc, C + ic * ldc + jc, ldc,
+                        beta != 0 || pc > 0);
+                }
+            }
+        }
+    }
+}
+
+void gemmTilesKernel(Transpose opA, Transpose opB, MatrixView<int> A, MatrixView<int> B, const BlockSizes& tiles,
+    int num_threads, const TileEpilogue& epilogue) {
+    const int m = opA == Transpose::N ? A.rows() : A.cols();
+    const int k = opA == Transpose::N ? A.cols() : A.rows();
+    const int kb = opB == Transpose::N ? B.rows() : B.cols();
+    const int n = opB == Transpose::N ? B.cols() : B.rows();
+    if (k != kb) {
+        throw std::invalid_argument("gemmTilesKernel: число столбцов op(A) не равно числу строк op(B)");
+    }
+    checkTiles(tiles);
+    if (m == 0 || n == 0) return;
+
+    const MicroKernel& kernel = activeMicroKernel();
+    const int blocks_i = (m + tiles.tile_i - 1) / tiles.tile_i;
+    const int chunks_k = (k + tiles.tile_k - 1) / tiles.tile_k;
+    // Панель op(B) на всю глубину: часть pc занимает panel * kc элементов начиная с panel * pc
+    const int panel = roundUp(std::min(tiles.tile_j, n), kernel.nr);
+    AlignedMatrix<int> Bp = AlignedMatrix<int>::uninitialized(1, std::max(1, panel * k));
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        AlignedMatrix<int> Ap(roundUp(std::min(tiles.tile_i, m), kernel.mr), std::max(1, std::min(tiles.tile_k, k)));
+        AlignedMatrix<int> tile(std::min(tiles.tile_i, m), std::min(tiles.tile_j, n));
+        const int worker = omp_get_thread_num();
+
+        for (int jc = 0; jc < n; jc += tiles.tile_j) {
+            const int nc = std::min(tiles.tile_j, n - jc);
+            const int width = roundUp(nc, kernel.nr);
+
+            if (opB == Transpose::N) {
+                #pragma omp for schedule(static)
+                for (int p = 0; p < k; p++) {
+                    const int pc = p / tiles.tile_k * tiles.tile_k;
+                    const int kc = std::min(tiles.tile_k, k - pc);
+                    packBRow(B, pc, jc, p - pc, nc, kc, kernel.nr, Bp.data() + static_cast<std::ptrdiff_t>(panel) * pc);
+                }
+            }
+            else {
+                #pragma omp for collapse(2) schedule(static)
+                for (int c = 0; c < chunks_k; c++) {
+                    for (int j = 0; j < width; j++) {
+                        const int pc = c * tiles.tile_k;
+                        const int kc = std::min(tiles.tile_k, k - pc);
+                        packBTransposedColumn(B, pc, jc, j, nc, kc, kernel.nr,
+                            Bp.data() + static_cast<std::ptrdiff_t>(panel) * pc);
+                    }
+                }
+            }
+
+            // Неявный барьер в конце цикла: панель не перепаковывается, пока её читают другие потоки
+            #pragma omp for schedule(static)
+            for (int bi = 0; bi < blocks_i; bi++) {
+                const int ic = bi * tiles.tile_i;
+                const int mc = std::min(tiles.tile_i, m - ic);
+                if (k == 0) zeroResult(tile.data(), tile.ld(), mc, nc);
+                for (int pc = 0; pc < k; pc += tiles.tile_k) {
+                    const int kc = std::min(tiles.tile_k, k - pc);
+                    packAScaled(A, opA, 1, ic, pc, mc, kc, kernel.mr, Ap.data());
+                    macroKernel(kernel, Ap.data(), Bp.data() + static_cast<std::ptrdiff_t>(panel) * pc, mc, nc, kc,
+                        tile.data(), tile.ld(), pc > 0);
+                }
+                epilogue(worker, ic, jc, mc, nc, tile.data(), tile.ld());
+            }
+        }
+    }
+}
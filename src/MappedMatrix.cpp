@@ -0,0 +1,302 @@
+#include "MappedMatrix.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "NarrowKernels.h"
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char MAGIC[8] = { 'P', 'P', 'M', 'A', 'T', 'R', 'I', 'X' };
+
+static_assert(sizeof(MatrixFileHeader) == MATRIX_ALIGNMENT, "Заголовок должен занимать одну кэш-линию");
+
+std::runtime_error fileError(const std::string& what, const std::string& path) {
+#ifdef _WIN32
+    return std::runtime_error(what + " " + path + " (код " + std::to_string(GetLastError()) + ")");
+#else
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+#endif
+}
+
+MatrixFileHeader makeHeader(int rows, int cols, std::ptrdiff_t ld) {
+    MatrixFileHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = MATRIX_FILE_VERSION;
+    header.elementType = static_cast<std::uint32_t>(ElementType::Int32);
+    header.rows = rows;
+    header.cols = cols;
+    header.ld = ld;
+    return header;
+}
+
+std::size_t fileBytes(std::int64_t rows, std::int64_t ld) {
+    return sizeof(MatrixFileHeader) + static_cast<std::size_t>(rows) * static_cast<std::size_t>(ld) * sizeof(int);
+}
+
+} // namespace
+
+MappedMatrix::MappedMatrix(MappedMatrix&& other) noexcept
+    : base_(std::exchange(other.base_, nullptr)), mappedBytes_(std::exchange(other.mappedBytes_, 0)),
+      data_(std::exchange(other.data_, nullptr)), rows_(std::exchange(other.rows_, 0)),
+      cols_(std::exchange(other.cols_, 0)), ld_(std::exchange(other.ld_, 0)), mode_(other.mode_) {}
+
+MappedMatrix& MappedMatrix::operator=(MappedMatrix&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        base_ = std::exchange(other.base_, nullptr);
+        mappedBytes_ = std::exchange(other.mappedBytes_, 0);
+        data_ = std::exchange(other.data_, nullptr);
+        rows_ = std::exchange(other.rows_, 0);
+        cols_ = std::exchange(other.cols_, 0);
+        ld_ = std::exchange(other.ld_, 0);
+        mode_ = other.mode_;
+    }
+    return *this;
+}
+
+MappedMatrix::~MappedMatrix() {
+    unmap();
+}
+
+void MappedMatrix::unmap() {
+    if (!base_) return;
+#ifdef _WIN32
+    UnmapViewOfFile(base_);
+#else
+    munmap(base_, mappedBytes_);
+#endif
+    base_ = nullptr;
+}
+
+// Отображение всего файла; при create файл создаётся заново размером createBytes (заполнен нулями)
+MappedMatrix MappedMatrix::map(const std::string& path, Mode mode, bool create, std::size_t createBytes) {
+    const bool rw = mode == Mode::ReadWrite;
+    std::size_t bytes = createBytes;
+    void* base = nullptr;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | (rw ? GENERIC_WRITE : 0), FILE_SHARE_READ, nullptr,
+        create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw fileError("Не удалось открыть файл", path);
+    LARGE_INTEGER size;
+    bool sized = true;
+    if (create) {
+        size.QuadPart = static_cast<LONGLONG>(bytes);
+        sized = SetFilePointerEx(file, size, nullptr, FILE_BEGIN) && SetEndOfFile(file);
+    }
+    else {
+        sized = GetFileSizeEx(file, &size);
+        bytes = static_cast<std::size_t>(size.QuadPart);
+    }
+    if (!sized || bytes < sizeof(MatrixFileHeader)) {
+        CloseHandle(file);
+        throw fileError("Неверный размер файла", path);
+    }
+    // Отображение держит файл открытым, дескрипторы можно закрыть сразу
+    HANDLE mapping = CreateFileMappingA(file, nullptr, rw ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) throw fileError("Не удалось отобразить файл", path);
+    base = MapViewOfFile(mapping, rw ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!base) throw fileError("Не удалось отобразить файл", path);
+#else
+    const int fd = ::open(path.c_str(), (rw ? O_RDWR : O_RDONLY) | (create ? O_CREAT | O_TRUNC : 0), 0644);
+    if (fd < 0) throw fileError("Не удалось открыть файл", path);
+    struct stat st;
+    const bool sized = create ? ftruncate(fd, static_cast<off_t>(bytes)) == 0 : fstat(fd, &st) == 0;
+    if (!create && sized) bytes = static_cast<std::size_t>(st.st_size);
+    if (!sized || bytes < sizeof(MatrixFileHeader)) {
+        ::close(fd);
+        throw fileError("Неверный размер файла", path);
+    }
+    // Отображение держит файл открытым, дескриптор можно закрыть сразу
+    base = mmap(nullptr, bytes, PROT_READ | (rw ? PROT_WRITE : 0), MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) throw fileError("Не удалось отобразить файл", path);
+#endif
+    MappedMatrix m;
+    m.base_ = base;
+    m.mappedBytes_ = bytes;
+    m.mode_ = mode;
+    return m;
+}
+
+MappedMatrix MappedMatrix::create(const std::string& path, int rows, int cols) {
+    if (rows < 0 || cols < 0) {
+        throw std::invalid_argument("MappedMatrix::create: размеры не могут быть отрицательными");
+    }
+    const std::ptrdiff_t ld = AlignedMatrix<int>::paddedLeadingDimension(cols);
+    MappedMatrix m = map(path, Mode::ReadWrite, true, fileBytes(rows, ld));
+    const MatrixFileHeader header = makeHeader(rows, cols, ld);
+    std::memcpy(m.base_, &header, sizeof(header));
+    m.data_ = reinterpret_cast<int*>(static_cast<char*>(m.base_) + sizeof(MatrixFileHeader));
+    m.rows_ = rows;
+    m.cols_ = cols;
+    m.ld_ = ld;
+    return m;
+}
+
+MappedMatrix MappedMatrix::open(const std::string& path, Mode mode) {
+    MappedMatrix m = map(path, mode, false, 0);
+    MatrixFileHeader header;
+    std::memcpy(&header, m.base_, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != MATRIX_FILE_VERSION) {
+        throw std::runtime_error("Файл " + path + " не является файлом матрицы");
+    }
+    if (header.elementType != static_cast<std::uint32_t>(ElementType::Int32)) {
+        throw std::runtime_error("Файл " + path + ": поддерживаются только матрицы int32");
+    }
+    // Шаг строки ограничивается размером файла до умножения: rows * ld не должно переполняться
+    const std::size_t maxLd = (m.mappedBytes_ - sizeof(MatrixFileHeader)) / sizeof(int)
+        / static_cast<std::size_t>(std::max<std::int64_t>(header.rows, 1));
+    if (header.rows < 0 || header.rows > INT_MAX || header.cols < 0 || header.cols > INT_MAX
+        || header.ld < header.cols || static_cast<std::uint64_t>(header.ld) > maxLd
+        || fileBytes(header.rows, header.ld) > m.mappedBytes_) {
+        throw std::runtime_error("Файл " + path + ": размеры в заголовке не соответствуют файлу");
+    }
+    m.data_ = reinterpret_cast<int*>(static_cast<char*>(m.base_) + sizeof(MatrixFileHeader));
+    m.rows_ = static_cast<int>(header.rows);
+    m.cols_ = static_cast<int>(header.cols);
+    m.ld_ = static_cast<std::ptrdiff_t>(header.ld);
+    return m;
+}
+
+int* MappedMatrix::mutableData() {
+    if (!writable()) {
+        throw std::invalid_argument("MappedMatrix: файл открыт только для чтения");
+    }
+    return data_;
+}
+
+void MappedMatrix::advise(int begin, int end, bool willNeed) const {
+    begin = std::max(begin, 0);
+    end = std::min(end, rows_);
+    if (begin >= end) return;
+#ifdef _WIN32
+    // Подсказки о подгрузке на Windows не используются: страницы читаются по обращению
+    (void)willNeed;
+#else
+    // madvise требует адрес, выровненный по странице: диапазон расширяется до целых страниц
+    const std::uintptr_t page = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    const std::uintptr_t first = reinterpret_cast<std::uintptr_t>(data_ + begin * ld_) / page * page;
+    const std::uintptr_t last = reinterpret_cast<std::uintptr_t>(data_ + end * ld_);
+    void* address = reinterpret_cast<void*>(first);
+    if (willNeed) {
+        madvise(address, last - first, MADV_WILLNEED);
+        return;
+    }
+    if (writable()) msync(address, last - first, MS_ASYNC);
+    madvise(address, last - first, MADV_DONTNEED);
+#endif
+}
+
+void MappedMatrix::prefetchRows(int begin, int end) const {
+    advise(begin, end, true);
+}
+
+void MappedMatrix::releaseRows(int begin, int end) const {
+    advise(begin, end, false);
+}
+
+void MappedMatrix::flush() const {
+    if (!base_ || !writable()) return;
+#ifdef _WIN32
+    const bool flushed = FlushViewOfFile(base_, mappedBytes_);
+#else
+    const bool flushed = msync(base_, mappedBytes_, MS_SYNC) == 0;
+#endif
+    if (!flushed) {
+        throw std::runtime_error("MappedMatrix::flush: не удалось записать изменения");
+    }
+}
+
+void writeMatrixFile(const std::string& path, MatrixView<int> m) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Не удалось открыть файл " + path);
+    }
+    const std::ptrdiff_t ld = AlignedMatrix<int>::paddedLeadingDimension(m.cols());
+    const MatrixFileHeader header = makeHeader(m.rows(), m.cols(), ld);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    std::vector<int> row(ld, 0);
+    for (int i = 0; i < m.rows(); i++) {
+        std::copy(m.row(i), m.row(i) + m.cols(), row.begin());
+        file.write(reinterpret_cast<const char*>(row.data()), ld * sizeof(int));
+    }
+    if (!file) {
+        throw std::runtime_error("Ошибка записи файла " + path);
+    }
+}
+
+double multiplyOutOfCore(const MappedMatrix& A, const MappedMatrix& B, MappedMatrix& C,
+    const OutOfCoreOptions& options) {
+    if (A.cols() != B.rows() || C.rows() != A.rows() || C.cols() != B.cols()) {
+        throw std::invalid_argument("multiplyOutOfCore: размеры A, B и C не согласованы");
+    }
+    const BlockSizes& tiles = options.tiles;
+    if (tiles.tile_i <= 0 || tiles.tile_j <= 0 || tiles.tile_k <= 0) {
+        throw std::invalid_argument("multiplyOutOfCore: размеры блоков должны быть положительными");
+    }
+    const int m = A.rows(), n = B.cols(), k = A.cols();
+    int* c = C.mutableData();
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    if (m == 0 || n == 0 || k == 0) {
+        gemmKernel(Transpose::N, Transpose::N, 1, A.view(), B.view(), 0, c, C.ld(), tiles, options.num_threads);
+    }
+    else {
+        // Высота панели C: панели A и C по panelM строк и две панели B по panelK строк в бюджете
+        const int panelK = std::min(tiles.tile_k, k);
+        const std::size_t panelsB = 2 * static_cast<std::size_t>(panelK) * n * sizeof(int);
+        const std::size_t perRow = (static_cast<std::size_t>(k) + n) * sizeof(int);
+        const std::size_t fit = options.memoryBudget > panelsB ? (options.memoryBudget - panelsB) / perRow : 0;
+        const int panelM = static_cast<int>(std::min<std::size_t>(
+            std::max<std::size_t>(fit / tiles.tile_i * tiles.tile_i, tiles.tile_i), m));
+        // B, помещающуюся в половину бюджета, выгоднее держать в памяти для всех панелей C
+        const bool dropB = B.dataBytes() > options.memoryBudget / 2;
+
+        A.prefetchRows(0, panelM);
+        B.prefetchRows(0, panelK);
+        for (int i0 = 0; i0 < m; i0 += panelM) {
+            const int rows = std::min(panelM, m - i0);
+            int* panelC = c + i0 * C.ld();
+            for (int p0 = 0; p0 < k; p0 += panelK) {
+                const int depth = std::min(panelK, k - p0);
+                // Подгрузка следующей панели B (после последней - первой, для следующей панели C)
+                // идёт параллельно с умножением текущей
+                if (p0 + depth < k) {
+                    B.prefetchRows(p0 + depth, p0 + depth + panelK);
+                }
+                else if (i0 + rows < m) {
+                    B.prefetchRows(0, panelK);
+                    A.prefetchRows(i0 + rows, i0 + rows + panelM);
+                }
+                gemmKernel(Transpose::N, Transpose::N, 1, A.view().block(i0, p0, rows, depth),
+                    B.view().block(p0, 0, depth, n), p0 == 0 ? 0 : 1, panelC, C.ld(), tiles, options.num_threads);
+                if (dropB) B.releaseRows(p0, p0 + depth);
+            }
+            A.releaseRows(i0, i0 + rows);
+            C.releaseRows(i0, i0 + rows);
+        }
+    }
+    C.flush();
+
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diff = end - start;
+    return diff.count();
+}
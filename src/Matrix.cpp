@@ -1,124 +1,997 @@
 #include "Matrix.h"
-#include <iostream>
+#include "AutoTuner.h"
+#include "Random.h"
+#include "FixedMatrix.h"
+#include "ThreadPool.h"
+#include "PerfCounters.h"
+#include "Verify.h"
+#include "ResultCache.h"
+#include <algorithm>
 #include <random>
 #include <chrono>
 #include <omp.h>
+#include <stdexcept>
 
-Matrix::Matrix(int n) : n(n) {
-    A.resize(n, std::vector<int>(n));
-    B.resize(n, std::vector<int>(n));
-    C.resize(n, std::vector<int>(n, 0));
+namespace {
+
+void checkUpdate(const char* method, int first, std::size_t count, int limit, const std::vector<std::vector<int>>& parts,
+    int length) {
+    if (first < 0 || first + static_cast<long long>(count) > limit) {
+        throw std::invalid_argument(std::string(method) + ": изменяемый диапазон выходит за пределы матрицы");
+    }
+    for (const auto& part : parts) {
+        if (static_cast<int>(part.size()) != length) {
+            throw std::invalid_argument(std::string(method) + ": длина строки или столбца должна быть "
+                + std::to_string(length));
+        }
+    }
+}
+
+void checkVectors(const char* method, const std::vector<int>& u, int rows, const std::vector<int>& v, int cols) {
+    if (static_cast<int>(u.size()) != rows || static_cast<int>(v.size()) != cols) {
+        throw std::invalid_argument(std::string(method) + ": длины векторов должны быть "
+            + std::to_string(rows) + " и " + std::to_string(cols));
+    }
+}
+
+// C[i0..i1) x [j0..j1) = A[i0..i1) * B[:, j0..j1): строка B читается один раз на все строки плитки
+void recomputeRows(MatrixView<int> A, MatrixView<int> B, AlignedMatrix<int>& C, int i0, int i1, int j0, int j1) {
+    const int width = j1 - j0;
+    for (int i = i0; i < i1; i++) std::fill(C.row(i) + j0, C.row(i) + j1, 0);
+    for (int p = 0; p < A.cols(); p++) {
+        const int* b = B.row(p) + j0;
+        for (int i = i0; i < i1; i++) {
+            const int a = A(i, p);
+            int* c = C.row(i) + j0;
+            #pragma omp simd
+            for (int j = 0; j < width; j++) {
+                c[j] += a * b[j];
+            }
+        }
+    }
+}
+
+// То же для нескольких столбцов: Bt - транспонированные столбцы B начиная с first, элементы C -
+// скалярные произведения строк A и Bt с единичным шагом
+void recomputeColumns(MatrixView<int> A, MatrixView<int> Bt, int first, AlignedMatrix<int>& C, int i0, int i1,
+    int j0, int j1) {
+    for (int i = i0; i < i1; i++) {
+        const int* a = A.row(i);
+        for (int j = j0; j < j1; j++) {
+            const int* b = Bt.row(j - first);
+            int sum = 0;
+            #pragma omp simd reduction(+ : sum)
+            for (int p = 0; p < A.cols(); p++) {
+                sum += a[p] * b[p];
+            }
+            C.row(i)[j] = sum;
+        }
+    }
+}
+
+// Непрерывные отрезки [first, last) отмеченных позиций
+std::vector<std::pair<int, int>> markedRuns(const std::vector<char>& marks) {
+    std::vector<std::pair<int, int>> runs;
+    const int count = static_cast<int>(marks.size());
+    for (int first = 0; first < count; first++) {
+        if (!marks[first]) continue;
+        int last = first;
+        while (last < count && marks[last]) last++;
+        runs.push_back({ first, last });
+        first = last;
+    }
+    return runs;
+}
+
+} // namespace
+
+Matrix::Matrix(int n) : Matrix(n, n, n) {}
+
+Matrix::Matrix(int m, int n, int k, Transpose opA, Transpose opB) : m(m), n(n), k(k), opA(opA), opB(opB) {
+    if (m < 0 || n < 0 || k < 0) {
+        throw std::invalid_argument("Размер матрицы не может быть отрицательным");
+    }
+    shapeA = opA == Transpose::N ? Shape{ m, k } : Shape{ k, m };
+    shapeB = opB == Transpose::N ? Shape{ k, n } : Shape{ n, k };
+    shapeC = Shape{ m, n };
+}
+
+const std::vector<std::vector<int>>& Matrix::nested(const AlignedMatrix<int>& mat, NestedCache& cache,
+    Shape shape) const {
+    std::lock_guard<std::mutex> lock(lazy.mutex);
+    if (!cache.valid) {
+        cache.data = mat.empty() ? std::vector<std::vector<int>>(shape.rows, std::vector<int>(shape.cols, 0))
+            : mat.toNested();
+        cache.valid = true;
+    }
+    return cache.data;
+}
+
+void Matrix::allocate(AlignedMatrix<int>& mat, Shape shape) const {
+    std::lock_guard<std::mutex> lock(lazy.mutex);
+    if (mat.empty() && shape.rows > 0 && shape.cols > 0) {
+        mat = AlignedMatrix<int>::uninitialized(shape.rows, shape.cols);
+        firstTouchZero(mat);
+    }
+}
+
+void Matrix::prepareOperands() {
+    allocate(A, shapeA);
+    allocate(B, shapeB);
+    allocate(C, shapeC);
+    // Внешние буферы A и B вызывающий код мог изменить после прошлого умножения
+    if (!A.owned() || !B.owned()) {
+        dropDerivedCopies();
+        if (!A.owned()) nestedA.valid = false;
+        if (!B.owned()) nestedB.valid = false;
+    }
+    // C перезаписывается: если умножение прервётся исключением, частичный пересчёт невозможен
+    resetUpdates(false);
+    cachePending = false;
+    cacheHit = false;
+}
+
+void Matrix::requireUntransposed(const char* method) const {
+    if (opA != Transpose::N || opB != Transpose::N) {
+        throw std::invalid_argument(std::string(method) + ": транспонированные операнды поддерживает только gemm");
+    }
+}
+
+void Matrix::checkShape(int rows, int cols, Shape shape) const {
+    if (rows != shape.rows || cols != shape.cols) {
+        throw std::invalid_argument("Размер матрицы должен быть " + std::to_string(shape.rows) + "x"
+            + std::to_string(shape.cols));
+    }
+}
+
+void Matrix::checkNested(const std::vector<std::vector<int>>& nestedM, Shape shape) const {
+    checkShape(static_cast<int>(nestedM.size()), shape.cols, shape);
+    for (const auto& row : nestedM) checkShape(shape.rows, static_cast<int>(row.size()), shape);
+}
+
+void Matrix::moveIn(AlignedMatrix<int>& mat, std::vector<std::vector<int>>&& nestedM, Shape shape) {
+    checkNested(nestedM, shape);
+    if (!mat.owned()) mat = AlignedMatrix<int>();
+    // Новый буфер не обнуляется заранее: страницы впервые касаются при копировании строк, а строки
+    // источника освобождаются сразу после копирования, так что пиковая память - одна матрица и строка
+    if (mat.empty() && shape.rows > 0 && shape.cols > 0) {
+        mat = AlignedMatrix<int>::uninitialized(shape.rows, shape.cols);
+    }
+    for (int i = 0; i < shape.rows; i++) {
+        int* row = mat.row(i);
+        std::copy(nestedM[i].begin(), nestedM[i].end(), row);
+        std::fill(row + shape.cols, row + mat.ld(), 0);
+        std::vector<int>().swap(nestedM[i]);
+    }
+    std::vector<std::vector<int>>().swap(nestedM);
+}
+
+void Matrix::markOperandsChanged() {
+    dropDerivedCopies();
+    resetUpdates(false);
+}
+
+void Matrix::dropDerivedCopies() {
+    hashes.valid = false;
+    narrow.valid8 = false;
+    narrow.valid16 = false;
+    sparse.validDensity = false;
+    sparse.validA = false;
+    sparse.validB = false;
+    sparse.validBc = false;
 }
 
 void Matrix::setMatrixA(const std::vector<std::vector<int>>& newA) {
-    A = newA;
+    checkNested(newA, shapeA);
+    if (!A.owned()) A = AlignedMatrix<int>();
+    allocate(A, shapeA);
+    A.assign(newA);
+    nestedA.valid = false;
+    markOperandsChanged();
 }
 void Matrix::setMatrixB(const std::vector<std::vector<int>>& newB) {
-    B = newB;
+    checkNested(newB, shapeB);
+    if (!B.owned()) B = AlignedMatrix<int>();
+    allocate(B, shapeB);
+    B.assign(newB);
+    nestedB.valid = false;
+    markOperandsChanged();
+}
+
+void Matrix::setMatrixC(const std::vector<std::vector<int>>& newC) {
+    allocate(C, shapeC);
+    C.assign(newC);
+    nestedC.valid = false;
+    resetUpdates(false);
+}
+
+void Matrix::setMatrixA(std::vector<std::vector<int>>&& newA) {
+    moveIn(A, std::move(newA), shapeA);
+    nestedA.valid = false;
+    markOperandsChanged();
+}
+void Matrix::setMatrixB(std::vector<std::vector<int>>&& newB) {
+    moveIn(B, std::move(newB), shapeB);
+    nestedB.valid = false;
+    markOperandsChanged();
+}
+
+void Matrix::setMatrixA(AlignedMatrix<int>&& newA) {
+    checkShape(newA.rows(), newA.cols(), shapeA);
+    A = std::move(newA);
+    nestedA.valid = false;
+    markOperandsChanged();
+}
+void Matrix::setMatrixB(AlignedMatrix<int>&& newB) {
+    checkShape(newB.rows(), newB.cols(), shapeB);
+    B = std::move(newB);
+    nestedB.valid = false;
+    markOperandsChanged();
+}
+
+// Матрицы A и B только читаются: setMatrix и initialize заменяют внешний буфер собственным,
+// поэтому снятие const с указателя безопасно
+void Matrix::adoptMatrixA(const int* data, int rows, int cols, std::ptrdiff_t ld) {
+    checkShape(rows, cols, shapeA);
+    A = AlignedMatrix<int>::adopt(const_cast<int*>(data), rows, cols, ld);
+    nestedA.valid = false;
+    markOperandsChanged();
+}
+void Matrix::adoptMatrixB(const int* data, int rows, int cols, std::ptrdiff_t ld) {
+    checkShape(rows, cols, shapeB);
+    B = AlignedMatrix<int>::adopt(const_cast<int*>(data), rows, cols, ld);
+    nestedB.valid = false;
+    markOperandsChanged();
+}
+void Matrix::adoptMatrixC(int* data, int rows, int cols, std::ptrdiff_t ld) {
+    checkShape(rows, cols, shapeC);
+    C = AlignedMatrix<int>::adopt(data, rows, cols, ld);
+    nestedC.valid = false;
+    resetUpdates(false);
 }
 
 const std::vector<std::vector<int>>& Matrix::getMatrixA() const {
-    return A;
+    return nested(A, nestedA, shapeA);
 }
 const std::vector<std::vector<int>>& Matrix::getMatrixB() const {
-    return B;
+    return nested(B, nestedB, shapeB);
 }
 const std::vector<std::vector<int>>& Matrix::getMatrixC() const {
-    return C;
+    return nested(C, nestedC, shapeC);
 }
 
-void Matrix::initialize() {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(-100, 100);
+MatrixView<int> Matrix::viewA() const {
+    allocate(A, shapeA);
+    return A.view();
+}
+MatrixView<int> Matrix::viewB() const {
+    allocate(B, shapeB);
+    return B.view();
+}
+MatrixView<int> Matrix::viewC() const {
+    allocate(C, shapeC);
+    return C.view();
+}
+
+ProductExpr Matrix::lazyProduct() const {
+    return product(viewA(), viewB(), opA, opB);
+}
+
+int Matrix::size() const {
+    return n;
+}
+
+int Matrix::rows() const {
+    return m;
+}
+int Matrix::cols() const {
+    return n;
+}
+int Matrix::inner() const {
+    return k;
+}
+
+void Matrix::setAffinity(const AffinityConfig& config) {
+    affinityPlan(config, 1);
+    affinityConfig = config;
+    placement = Placement();
+}
+
+const AffinityConfig& Matrix::affinity() const {
+    return affinityConfig;
+}
+
+SavedAffinity Matrix::applyAffinity(int num_threads) {
+    const std::vector<int> plan = affinityPlan(affinityConfig, num_threads);
+    // Поток 0 команды - вызывающий: его прежние ядра восстанавливаются, когда умножение вернёт управление
+    SavedAffinity caller;
+    if (!plan.empty()) {
+        caller = SavedAffinity::capture();
+        #pragma omp parallel num_threads(num_threads)
+        pinCurrentThread(plan[omp_get_thread_num()]);
+    }
+    placeOperands(num_threads, plan);
+    return caller;
+}
 
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
-            A[i][j] = dis(gen);
-            B[i][j] = dis(gen);
+void Matrix::placeOperands(int num_threads, const std::vector<int>& plan) {
+    if (!affinityConfig.numaPlacement) return;
+    if (placement.threads == num_threads && placement.a == A.data() && placement.b == B.data()
+        && placement.c == C.data()) {
+        return;
+    }
+
+    // Узлы потоков: по плану закрепления, без закрепления - где потоки выполняются сейчас
+    std::vector<int> nodes(num_threads, -1);
+    if (!plan.empty()) {
+        for (int t = 0; t < num_threads; t++) nodes[t] = NumaTopology::system().nodeOf(plan[t]);
+    }
+    else {
+        #pragma omp parallel num_threads(num_threads)
+        nodes[omp_get_thread_num()] = currentNumaNode();
+    }
+
+    // Внешние буферы (adopt) не переносятся: их размещением управляет владелец
+    auto placeRows = [&](AlignedMatrix<int>& mat) {
+        if (!mat.owned() || mat.empty()) return;
+        for (int t = 0; t < num_threads; t++) {
+            const int r0 = static_cast<int>(static_cast<long long>(mat.rows()) * t / num_threads);
+            const int r1 = static_cast<int>(static_cast<long long>(mat.rows()) * (t + 1) / num_threads);
+            if (nodes[t] >= 0 && r1 > r0) {
+                placeMemoryOnNode(mat.row(r0), static_cast<std::size_t>(r1 - r0) * mat.ld() * sizeof(int), nodes[t]);
+            }
         }
+    };
+    if (B.owned()) interleaveMemory(B.data(), B.sizeBytes());
+    if (opA == Transpose::N) placeRows(A);
+    else if (A.owned()) interleaveMemory(A.data(), A.sizeBytes());
+    placeRows(C);
+    placement = { num_threads, A.data(), B.data(), C.data() };
+}
+
+void Matrix::enablePerfCounters(bool enabled) {
+    perfEnabled = enabled;
+    perf = PerfReport();
+}
+
+const PerfReport& Matrix::lastPerfCounters() const {
+    return perf;
+}
+
+void Matrix::countersBegin(int num_threads) {
+    if (!perfEnabled || num_threads <= 0) return;
+    if (num_threads == 1) {
+        perfThreadStart();
+        return;
+    }
+    #pragma omp parallel num_threads(num_threads)
+    perfThreadStart();
+}
+
+void Matrix::countersEnd(int num_threads) {
+    if (!perfEnabled) return;
+    perf.threads.assign(std::max(num_threads, 0), PerfCounts());
+    if (num_threads <= 0) return;
+    if (num_threads == 1) {
+        perf.threads[0] = perfThreadStop();
+        return;
+    }
+    #pragma omp parallel num_threads(num_threads)
+    perf.threads[omp_get_thread_num()] = perfThreadStop();
+}
+
+bool Matrix::verify(int rounds, int num_threads, std::uint64_t seed) const {
+    return freivaldsCheck(opA, opB, 1, viewA(), viewB(), viewC(), rounds, seed, num_threads);
+}
+
+void Matrix::setVerification(int rounds) {
+    if (rounds < 0 || rounds > FREIVALDS_MAX_ROUNDS) {
+        throw std::invalid_argument("setVerification: число раундов должно быть от 0 до "
+            + std::to_string(FREIVALDS_MAX_ROUNDS));
     }
+    verifyRounds = rounds;
+}
+
+void Matrix::checkResult(int num_threads, int alpha) const {
+    if (verifyRounds == 0) return;
+    if (!freivaldsCheck(opA, opB, alpha, A.view(), B.view(), C.view(), verifyRounds, FREIVALDS_SEED, num_threads)) {
+        throw std::runtime_error("Результат умножения не прошёл проверку Фрейвалдса");
+    }
+}
+
+const MultiplyTelemetry& Matrix::lastTelemetry() const {
+    return telemetry;
+}
+
+void Matrix::initialize() {
+    std::random_device rd;
+    initialize((static_cast<std::uint64_t>(rd()) << 32) | rd());
+}
+
+void Matrix::initialize(std::uint64_t seed) {
+    initialize(seed, 1.0, 1.0);
+}
+
+void Matrix::initialize(std::uint64_t seed, double densityA, double densityB) {
+    // Собственные буферы выделяются без обнуления: первое касание страниц делает fillRandom
+    if (!A.owned() || A.empty()) A = AlignedMatrix<int>::uninitialized(shapeA.rows, shapeA.cols);
+    if (!B.owned() || B.empty()) B = AlignedMatrix<int>::uninitialized(shapeB.rows, shapeB.cols);
+    fillRandom(A, seed, 0, -100, 100, densityA);
+    fillRandom(B, seed, 1, -100, 100, densityB);
+    nestedA.valid = false;
+    nestedB.valid = false;
+    markOperandsChanged();
 }
 
 double Matrix::multiplyLinear() {
+    requireUntransposed("multiplyLinear");
+    prepareOperands();
+    double cached = 0;
+    if (loadCached(1, cached)) return cached;
+    const int* b = B.data();
+    const std::ptrdiff_t ldb = B.ld();
+    nestedC.valid = false;
+    countersBegin(1);
     auto start = std::chrono::high_resolution_clock::now();
 
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
-            int sum = 0;
-            for (int k = 0; k < n; k++) {
-                sum += A[i][k] * B[k][j];
+    // Для размеров 4, 8, 16, 32 - ядро с размером, известным при компиляции
+    if (m != n || n != k || !multiplyFixedDispatch(n, A.data(), A.ld(), b, ldb, C.data(), C.ld())) {
+        for (int i = 0; i < m; i++) {
+            const int* a = A.row(i);
+            int* c = C.row(i);
+            for (int j = 0; j < n; j++) {
+                int sum = 0;
+                for (int p = 0; p < k; p++) {
+                    sum += a[p] * b[p * ldb + j];
+                }
+                c[j] = sum;
             }
-            C[i][j] = sum;
         }
     }
 
     auto end = std::chrono::high_resolution_clock::now();
+    countersEnd(1);
+    checkResult(1);
+    resetUpdates(true);
     std::chrono::duration<double> diff = end - start;
+    storeCached(diff.count());
     return diff.count();
 }
 
-double Matrix::multiplyParallel(int num_threads, const std::string& type) {
-    omp_set_num_threads(num_threads);
+double Matrix::multiplyParallel(int num_threads, const std::string& type, int chunk) {
+    if (num_threads <= 0) {
+        throw std::invalid_argument("multiplyParallel: количество потоков должно быть положительным");
+    }
+    const bool stealing = type == WORK_STEALING_SCHEDULE;
+    if (stealing && chunk < 0) {
+        throw std::invalid_argument("Размер порции не может быть отрицательным");
+    }
+    if (!stealing) setRuntimeSchedule(type, chunk);
+    requireUntransposed("multiplyParallel");
+    prepareOperands();
+    double cached = 0;
+    if (loadCached(num_threads, cached)) return cached;
+    SavedAffinity caller;
+    if (!stealing) caller = applyAffinity(num_threads);
+
+    const int* b = B.data();
+    const std::ptrdiff_t ldb = B.ld();
+    nestedC.valid = false;
+    // В пуле ячейки телеметрии нумеруются потоками пула, в OpenMP - потоками команды
+    std::vector<TelemetrySlot> slots(stealing ? ThreadPool::shared().size() : num_threads);
+    int team_size = 0;
+
+    countersBegin(stealing ? 0 : num_threads);
     auto start = std::chrono::high_resolution_clock::now();
-    int tid = 0;
-    double thread_start_time = 0;
-    double thread_time = 0;
-
-    #pragma omp parallel private(tid, thread_start_time, thread_time)
-    {
-        tid = omp_get_thread_num();
-        thread_start_time = omp_get_wtime();
-        std::cout << "[Поток " << tid << " запущен]\n";
-
-        // Статическая планировка
-        if (type == "static") {
-            #pragma omp parallel for schedule(static) collapse(2)
-            for (int i = 0; i < n; i++) {
-                for (int j = 0; j < n; j++) {
-                    int sum = 0;
-                    for (int k = 0; k < n; k++) {
-                        sum += A[i][k] * B[k][j];
-                    }
-                    C[i][j] = sum;
+    const double region_start = omp_get_wtime();
+
+    if (stealing) {
+        ThreadPool::shared().parallelFor2D(m, n, chunk > 0 ? chunk : STEAL_TILE_ROWS, STEAL_TILE_COLS, num_threads,
+            [&](int worker, int i0, int i1, int j0, int j1) {
+                ThreadTelemetry& record = slots[worker].record;
+                if (record.iterations == 0) {
+                    record.thread = worker;
+                    record.cpu = currentCpu();
+                    record.node = NumaTopology::system().nodeOf(record.cpu);
+                    record.start = omp_get_wtime() - region_start;
                 }
-            }
-        }
-        // Динамическая планировка
-        else if (type == "dynamic") {
-            #pragma omp parallel for schedule(dynamic) collapse(2)
-            for (int i = 0; i < n; i++) {
-                for (int j = 0; j < n; j++) {
-                    int sum = 0;
-                    for (int k = 0; k < n; k++) {
-                        sum += A[i][k] * B[k][j];
+                for (int i = i0; i < i1; i++) {
+                    const int* a = A.row(i);
+                    for (int j = j0; j < j1; j++) {
+                        int sum = 0;
+                        for (int p = 0; p < k; p++) {
+                            sum += a[p] * b[p * ldb + j];
+                        }
+                        C(i, j) = sum;
                     }
-                    C[i][j] = sum;
                 }
-            }
-        }
-        // Управляемая планировка
-        else if (type == "guided") {
-            #pragma omp parallel for schedule(guided) collapse(2)
-            for (int i = 0; i < n; i++) {
+                record.iterations += static_cast<long long>(i1 - i0) * (j1 - j0);
+                record.end = omp_get_wtime() - region_start;
+            });
+        team_size = static_cast<int>(slots.size());
+    }
+    else {
+        #pragma omp parallel num_threads(num_threads)
+        {
+            ThreadTelemetry& record = slots[omp_get_thread_num()].record;
+            record.thread = omp_get_thread_num();
+            record.cpu = currentCpu();
+            record.node = NumaTopology::system().nodeOf(record.cpu);
+            record.start = omp_get_wtime() - region_start;
+            long long iterations = 0;
+
+            #pragma omp single nowait
+            team_size = omp_get_num_threads();
+
+            // Пространство (i, j) делится между потоками одной команды, тип планировки задан через omp_set_schedule
+            #pragma omp for schedule(runtime) collapse(2) nowait
+            for (int i = 0; i < m; i++) {
                 for (int j = 0; j < n; j++) {
+                    const int* a = A.row(i);
                     int sum = 0;
-                    for (int k = 0; k < n; k++) {
-                        sum += A[i][k] * B[k][j];
+                    for (int p = 0; p < k; p++) {
+                        sum += a[p] * b[p * ldb + j];
                     }
-                    C[i][j] = sum;
+                    C(i, j) = sum;
+                    iterations++;
                 }
             }
-        }
 
-        thread_time = omp_get_wtime() - thread_start_time;
-        #pragma omp critical
-        {
-            std::cout << "[Поток " << tid << " завершил работу за " << thread_time << " секунд]\n";
+            record.iterations = iterations;
+            record.end = omp_get_wtime() - region_start;
         }
     }
 
     auto end = std::chrono::high_resolution_clock::now();
+    countersEnd(stealing ? 0 : num_threads);
+    checkResult(num_threads);
+    resetUpdates(true);
     std::chrono::duration<double> duration = end - start;
+    storeCached(duration.count());
+
+    telemetry.schedule = type;
+    telemetry.requestedThreads = num_threads;
+    telemetry.totalTime = duration.count();
+    telemetry.threads.clear();
+    for (int tid = 0; tid < team_size; tid++) {
+        // Потоки пула, не получившие ни одной плитки, в телеметрию не попадают
+        if (stealing && slots[tid].record.iterations == 0) continue;
+        telemetry.threads.push_back(slots[tid].record);
+    }
     return duration.count();
 }
+
+double Matrix::multiplyBlocked(int tile_i, int tile_j, int tile_k) {
+    requireUntransposed("multiplyBlocked");
+    prepareOperands();
+    double cached = 0;
+    if (loadCached(1, cached)) return cached;
+    const BlockSizes tiles{ tile_i, tile_j, tile_k };
+    nestedC.valid = false;
+    countersBegin(1);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    multiplyBlockedKernel(A.view(), B.view(), C.data(), C.ld(), tiles);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    countersEnd(1);
+    checkResult(1);
+    resetUpdates(true);
+    std::chrono::duration<double> diff = end - start;
+    storeCached(diff.count());
+    return diff.count();
+}
+
+double Matrix::multiplyBlockedParallel(int num_threads, int tile_i, int tile_j, int tile_k,
+    const std::string& type, int chunk) {
+    requireUntransposed("multiplyBlockedParallel");
+    prepareOperands();
+    double cached = 0;
+    if (loadCached(num_threads, cached)) return cached;
+    SavedAffinity caller;
+    if (type != WORK_STEALING_SCHEDULE) caller = applyAffinity(num_threads);
+    const BlockSizes tiles{ tile_i, tile_j, tile_k };
+    nestedC.valid = false;
+    countersBegin(type == WORK_STEALING_SCHEDULE ? 0 : num_threads);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    multiplyBlockedKernelParallel(A.view(), B.view(), C.data(), C.ld(), tiles, num_threads, type, chunk);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    countersEnd(type == WORK_STEALING_SCHEDULE ? 0 : num_threads);
+    checkResult(num_threads);
+    resetUpdates(true);
+    std::chrono::duration<double> diff = end - start;
+    storeCached(diff.count());
+    return diff.count();
+}
+
+double Matrix::multiplyStrassen(int num_threads, int cutoff) {
+    requireUntransposed("multiplyStrassen");
+    prepareOperands();
+    double cached = 0;
+    if (loadCached(num_threads, cached)) return cached;
+    const SavedAffinity caller = applyAffinity(num_threads);
+    nestedC.valid = false;
+    countersBegin(num_threads);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    multiplyStrassenKernel(A.view(), B.view(), C.data(), C.ld(), cutoff, num_threads);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    countersEnd(num_threads);
+    checkResult(num_threads);
+    resetUpdates(true);
+    std::chrono::duration<double> diff = end - start;
+    storeCached(diff.count());
+    return diff.count();
+}
+
+double Matrix::multiplyNarrow(int num_threads, ElementType type, Accumulation accumulation) {
+    requireUntransposed("multiplyNarrow");
+    prepareOperands();
+    const SavedAffinity caller = applyAffinity(num_threads);
+    if (type == ElementType::Int8 && !narrow.valid8) {
+        narrow.A8 = narrowCopy<std::int8_t>(A.view());
+        narrow.B8 = narrowCopy<std::int8_t>(B.view());
+        narrow.valid8 = true;
+    }
+    if (type == ElementType::Int16 && !narrow.valid16) {
+        narrow.A16 = narrowCopy<std::int16_t>(A.view());
+        narrow.B16 = narrowCopy<std::int16_t>(B.view());
+        narrow.valid16 = true;
+    }
+    // Кэш проверяется после сужения: операнды, не помещающиеся в тип, отклоняются и при попадании.
+    // Переполнение при Int64Checked обнаруживается только умножением, поэтому ключ включает накопление
+    double cached = 0;
+    if (loadCached(num_threads, cached, type, accumulation)) return cached;
+    nestedC.valid = false;
+    countersBegin(num_threads);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    const bool checked = accumulation == Accumulation::Int64Checked;
+    switch (type) {
+    case ElementType::Int8:
+        if (checked) multiplyCheckedKernel(narrow.A8.view(), narrow.B8.view(), C.data(), C.ld(), num_threads);
+        else multiplyNarrowKernel(narrow.A8.view(), narrow.B8.view(), C.data(), C.ld(), num_threads);
+        break;
+    case ElementType::Int16:
+        if (checked) multiplyCheckedKernel(narrow.A16.view(), narrow.B16.view(), C.data(), C.ld(), num_threads);
+        else multiplyNarrowKernel(narrow.A16.view(), narrow.B16.view(), C.data(), C.ld(), num_threads);
+        break;
+    case ElementType::Int32:
+        if (checked) multiplyCheckedKernel(A.view(), B.view(), C.data(), C.ld(), num_threads);
+        else multiplyBlockedKernelParallel(A.view(), B.view(), C.data(), C.ld(), BlockSizes(), num_threads);
+        break;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    countersEnd(num_threads);
+    checkResult(num_threads);
+    resetUpdates(true);
+    std::chrono::duration<double> diff = end - start;
+    storeCached(diff.count());
+    return diff.count();
+}
+
+double Matrix::multiplyAuto() {
+    return multiplyAuto(AutoTuner::instance());
+}
+
+double Matrix::multiplyAuto(AutoTuner& tuner) {
+    const TuningConfig config = tuner.configFor(std::max(m, std::max(n, k)));
+    return multiplyBlockedParallel(config.threads, config.tiles.tile_i, config.tiles.tile_j, config.tiles.tile_k,
+        config.schedule, config.chunk);
+}
+
+double Matrix::gemm(int alpha, int beta, int num_threads, const std::string& type, int chunk) {
+    prepareOperands();
+    double cached = 0;
+    if (alpha == 1 && beta == 0 && loadCached(num_threads, cached)) return cached;
+    SavedAffinity caller;
+    if (type != WORK_STEALING_SCHEDULE) caller = applyAffinity(num_threads);
+    nestedC.valid = false;
+    countersBegin(type == WORK_STEALING_SCHEDULE ? 0 : num_threads);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    gemmKernel(opA, opB, alpha, A.view(), B.view(), beta, C.data(), C.ld(), BlockSizes(), num_threads, type, chunk);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    countersEnd(type == WORK_STEALING_SCHEDULE ? 0 : num_threads);
+    if (beta == 0) checkResult(num_threads, alpha);
+    resetUpdates(alpha == 1 && beta == 0);
+    std::chrono::duration<double> diff = end - start;
+    storeCached(diff.count());
+    return diff.count();
+}
+
+double Matrix::multiplySparse(int num_threads, SparsePath path, double threshold) {
+    requireUntransposed("multiplySparse");
+    prepareOperands();
+    double cached = 0;
+    if (loadCached(num_threads, cached)) return cached;
+    const SavedAffinity caller = applyAffinity(num_threads);
+    if (path == SparsePath::Auto) {
+        if (!sparse.validDensity) {
+            sparse.densityA = density(A.view(), num_threads);
+            sparse.densityB = density(B.view(), num_threads);
+            sparse.validDensity = true;
+        }
+        path = chooseSparsePath(sparse.densityA, sparse.densityB, threshold);
+    }
+    const bool useA = path == SparsePath::SparseA || path == SparsePath::SparseAB;
+    const bool useB = path == SparsePath::SparseB || path == SparsePath::SparseAB;
+    if (useA && !sparse.validA) {
+        sparse.A = CsrMatrix::fromDense(A.view(), num_threads);
+        sparse.validA = true;
+    }
+    if (useA && useB && !sparse.validB) {
+        sparse.B = CsrMatrix::fromDense(B.view(), num_threads);
+        sparse.validB = true;
+    }
+    if (!useA && useB && !sparse.validBc) {
+        sparse.Bc = CscMatrix::fromDense(B.view(), num_threads);
+        sparse.validBc = true;
+    }
+    lastSparse = path;
+    nestedC.valid = false;
+    countersBegin(num_threads);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    if (useA && useB) spgemmKernel(sparse.A, sparse.B, C.data(), C.ld(), num_threads);
+    else if (useA) spmmKernel(sparse.A, B.view(), C.data(), C.ld(), num_threads);
+    else if (useB) spmmKernel(A.view(), sparse.Bc, C.data(), C.ld(), num_threads);
+    else multiplyBlockedKernelParallel(A.view(), B.view(), C.data(), C.ld(), BlockSizes(), num_threads);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    countersEnd(num_threads);
+    checkResult(num_threads);
+    resetUpdates(true);
+    std::chrono::duration<double> diff = end - start;
+    storeCached(diff.count());
+    return diff.count();
+}
+
+SparsePath Matrix::lastSparsePath() const {
+    return lastSparse;
+}
+
+void Matrix::resetUpdates(bool current) {
+    updates.current = current;
+    updates.rows.assign(current ? m : 0, 0);
+    updates.cols.assign(current ? n : 0, 0);
+    updates.left.clear();
+    updates.right.clear();
+}
+
+void Matrix::beginUpdate(const char* method, AlignedMatrix<int>& mat, NestedCache& cache, Shape shape) {
+    requireUntransposed(method);
+    allocate(mat, shape);
+    // Внешний буфер только читается: изменения пишутся в собственную копию
+    if (!mat.owned()) mat = AlignedMatrix<int>(mat);
+    cache.valid = false;
+    dropDerivedCopies();
+}
+
+void Matrix::updateRowsA(int row0, const std::vector<std::vector<int>>& rows) {
+    checkUpdate("updateRowsA", row0, rows.size(), m, rows, k);
+    beginUpdate("updateRowsA", A, nestedA, shapeA);
+    for (std::size_t r = 0; r < rows.size(); r++) {
+        std::copy(rows[r].begin(), rows[r].end(), A.row(row0 + static_cast<int>(r)));
+        if (updates.current) updates.rows[row0 + r] = 1;
+    }
+}
+
+void Matrix::updateRowsB(int row0, const std::vector<std::vector<int>>& rows) {
+    checkUpdate("updateRowsB", row0, rows.size(), k, rows, n);
+    beginUpdate("updateRowsB", B, nestedB, shapeB);
+    for (std::size_t r = 0; r < rows.size(); r++) {
+        const int p = row0 + static_cast<int>(r);
+        int* b = B.row(p);
+        if (updates.current) {
+            std::vector<int> column(m);
+            for (int i = 0; i < m; i++) column[i] = A(i, p);
+            std::vector<int> delta(n);
+            for (int j = 0; j < n; j++) delta[j] = rows[r][j] - b[j];
+            updates.left.push_back(std::move(column));
+            updates.right.push_back(std::move(delta));
+        }
+        std::copy(rows[r].begin(), rows[r].end(), b);
+    }
+}
+
+void Matrix::updateColumnsB(int col0, const std::vector<std::vector<int>>& columns) {
+    checkUpdate("updateColumnsB", col0, columns.size(), n, columns, k);
+    beginUpdate("updateColumnsB", B, nestedB, shapeB);
+    for (std::size_t c = 0; c < columns.size(); c++) {
+        const int j = col0 + static_cast<int>(c);
+        for (int p = 0; p < k; p++) B.row(p)[j] = columns[c][p];
+        if (updates.current) updates.cols[j] = 1;
+    }
+}
+
+void Matrix::rankOneUpdateA(const std::vector<int>& u, const std::vector<int>& v) {
+    checkVectors("rankOneUpdateA", u, m, v, k);
+    beginUpdate("rankOneUpdateA", A, nestedA, shapeA);
+    if (updates.current) {
+        // v^T * B: строки B с нулевым v[p] пропускаются
+        std::vector<int> row(n, 0);
+        for (int p = 0; p < k; p++) {
+            if (v[p] == 0) continue;
+            const int* b = B.row(p);
+            for (int j = 0; j < n; j++) row[j] += v[p] * b[j];
+        }
+        updates.left.push_back(u);
+        updates.right.push_back(std::move(row));
+    }
+    for (int i = 0; i < m; i++) {
+        if (u[i] == 0) continue;
+        int* a = A.row(i);
+        for (int p = 0; p < k; p++) a[p] += u[i] * v[p];
+    }
+}
+
+void Matrix::rankOneUpdateB(const std::vector<int>& u, const std::vector<int>& v) {
+    checkVectors("rankOneUpdateB", u, k, v, n);
+    beginUpdate("rankOneUpdateB", B, nestedB, shapeB);
+    if (updates.current) {
+        std::vector<int> column(m, 0);
+        for (int i = 0; i < m; i++) {
+            const int* a = A.row(i);
+            int sum = 0;
+            for (int p = 0; p < k; p++) sum += a[p] * u[p];
+            column[i] = sum;
+        }
+        updates.left.push_back(std::move(column));
+        updates.right.push_back(v);
+    }
+    for (int p = 0; p < k; p++) {
+        if (u[p] == 0) continue;
+        int* b = B.row(p);
+        for (int j = 0; j < n; j++) b[j] += u[p] * v[j];
+    }
+}
+
+double Matrix::recompute(int num_threads) {
+    requireUntransposed("recompute");
+    // Пересчёт кэш не использует: признак попадания предыдущего умножения сбрасывается
+    cacheHit = false;
+    cachePending = false;
+    const std::vector<std::pair<int, int>> rowRuns = markedRuns(updates.rows);
+    const std::vector<std::pair<int, int>> colRuns = markedRuns(updates.cols);
+    long long dirtyRows = 0, dirtyCols = 0;
+    for (const auto& run : rowRuns) dirtyRows += run.second - run.first;
+    for (const auto& run : colRuns) dirtyCols += run.second - run.first;
+    const int rank = static_cast<int>(updates.left.size());
+    const long long partial = (static_cast<long long>(rank) * m + dirtyRows * k) * n + dirtyCols * m * k;
+    if (!updates.current || partial >= static_cast<long long>(m) * n * k) {
+        return multiplyBlockedParallel(num_threads);
+    }
+
+    // Поправка ранга r собирается в плотные U (m x r) и V (r x n) вне замеряемого интервала
+    AlignedMatrix<int> U = AlignedMatrix<int>::uninitialized(m, rank);
+    AlignedMatrix<int> V = AlignedMatrix<int>::uninitialized(rank, n);
+    for (int r = 0; r < rank; r++) {
+        for (int i = 0; i < m; i++) U.row(i)[r] = updates.left[r][i];
+        std::copy(updates.right[r].begin(), updates.right[r].end(), V.row(r));
+    }
+    struct Tile {
+        int i0, i1, j0, j1;
+        int run;    ///< для плиток столбцов - номер отрезка столбцов
+    };
+    std::vector<Tile> rowTiles, colTiles;
+    for (const auto& run : rowRuns) {
+        for (int i0 = run.first; i0 < run.second; i0 += RECOMPUTE_TILE_ROWS) {
+            for (int j0 = 0; j0 < n; j0 += RECOMPUTE_TILE_COLS) {
+                rowTiles.push_back({ i0, std::min(i0 + RECOMPUTE_TILE_ROWS, run.second), j0, std::min(j0 + RECOMPUTE_TILE_COLS, n), -1 });
+            }
+        }
+    }
+    for (int r = 0; r < static_cast<int>(colRuns.size()); r++) {
+        for (int j0 = colRuns[r].first; j0 < colRuns[r].second; j0 += RECOMPUTE_TILE_COLS) {
+            for (int i0 = 0; i0 < m; i0 += RECOMPUTE_TILE_ROWS) {
+                colTiles.push_back({ i0, std::min(i0 + RECOMPUTE_TILE_ROWS, m), j0,
+                    std::min(j0 + RECOMPUTE_TILE_COLS, colRuns[r].second), r });
+            }
+        }
+    }
+    std::vector<AlignedMatrix<int>> columns(colRuns.size());
+
+    nestedC.valid = false;
+    countersBegin(num_threads);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    if (rank > 0) {
+        gemmKernel(Transpose::N, Transpose::N, 1, U.view(), V.view(), 1, C.data(), C.ld(), BlockSizes(), num_threads);
+    }
+    // Отмеченные строки и столбцы перезаписываются целиком, поэтому идут после поправки; плитки
+    // строк и столбцов пересекаются, и их наборы выполняются по очереди
+    const int rowCount = static_cast<int>(rowTiles.size());
+    #pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+    for (int t = 0; t < rowCount; t++) {
+        const Tile& tile = rowTiles[t];
+        recomputeRows(A.view(), B.view(), C, tile.i0, tile.i1, tile.j0, tile.j1);
+    }
+    // Узкие отрезки столбцов B транспонируются, чтобы читаться с единичным шагом
+    for (std::size_t r = 0; r < colRuns.size(); r++) {
+        const int first = colRuns[r].first;
+        columns[r] = AlignedMatrix<int>::uninitialized(colRuns[r].second - first, k);
+        for (int p = 0; p < k; p++) {
+            const int* b = B.row(p);
+            for (int j = first; j < colRuns[r].second; j++) columns[r].row(j - first)[p] = b[j];
+        }
+    }
+    const int colCount = static_cast<int>(colTiles.size());
+    #pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+    for (int t = 0; t < colCount; t++) {
+        const Tile& tile = colTiles[t];
+        recomputeColumns(A.view(), columns[tile.run].view(), colRuns[tile.run].first, C, tile.i0, tile.i1,
+            tile.j0, tile.j1);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    countersEnd(num_threads);
+    checkResult(num_threads);
+    resetUpdates(true);
+    std::chrono::duration<double> diff = end - start;
+    return diff.count();
+}
+
+void Matrix::setResultCache(std::shared_ptr<ResultCache> cache) {
+    resultCache = std::move(cache);
+}
+
+std::shared_ptr<ResultCache> Matrix::getResultCache() const {
+    return resultCache;
+}
+
+bool Matrix::lastCacheHit() const {
+    return cacheHit;
+}
+
+bool Matrix::loadCached(int num_threads, double& seconds, ElementType type, Accumulation accumulation) {
+    if (!resultCache) return false;
+    auto start = std::chrono::high_resolution_clock::now();
+    // Хеши операндов запоминаются до их изменения: повторные умножения тех же A и B не хешируют заново.
+    // Внешний буфер мог измениться без ведома объекта, его хеш сброшен в prepareOperands
+    if (!hashes.valid) {
+        hashes.a = hashMatrix(A.view(), num_threads);
+        hashes.b = hashMatrix(B.view(), num_threads);
+        hashes.valid = true;
+        std::chrono::duration<double> hashing = std::chrono::high_resolution_clock::now() - start;
+        resultCache->recordHashing(hashing.count());
+    }
+    ResultKey key;
+    key.a = hashes.a;
+    key.b = hashes.b;
+    key.m = m;
+    key.n = n;
+    key.k = k;
+    key.opA = opA;
+    key.opB = opB;
+    key.type = type;
+    key.accumulation = accumulation;
+    const std::shared_ptr<const AlignedMatrix<int>> found = resultCache->find(key);
+    if (!found) {
+        pendingKey = key;
+        cachePending = true;
+        return false;
+    }
+
+    for (int i = 0; i < m; i++) std::copy(found->row(i), found->row(i) + n, C.row(i));
+    nestedC.valid = false;
+    if (perfEnabled) perf = PerfReport();
+    telemetry = MultiplyTelemetry();
+    resetUpdates(true);
+    cacheHit = true;
+    std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+    seconds = diff.count();
+    return true;
+}
+
+void Matrix::storeCached(double seconds) {
+    if (!cachePending) return;
+    cachePending = false;
+    resultCache->recordMultiply(seconds);
+    resultCache->insert(pendingKey, C.view());
+}
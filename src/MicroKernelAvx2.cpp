@@ -0,0 +1,46 @@
+// Собирается с -mavx2 (/arch:AVX2). Не использовать здесь inline-функции и шаблоны из общих
+// заголовков: их экземпляры с AVX2-инструкциями могут попасть в код, работающий на любом процессоре.
+#include "MicroKernels.h"
+#include <immintrin.h>
+
+// Блок 6 x 16: 12 накопителей по 8 int32, две загрузки B и одна рассылка A на каждый шаг k
+void microKernelAvx2(int kc, const int* Ap, const int* Bp, int* C, std::ptrdiff_t ldc, bool accumulate) {
+    __m256i c00 = _mm256_setzero_si256(), c01 = _mm256_setzero_si256();
+    __m256i c10 = _mm256_setzero_si256(), c11 = _mm256_setzero_si256();
+    __m256i c20 = _mm256_setzero_si256(), c21 = _mm256_setzero_si256();
+    __m256i c30 = _mm256_setzero_si256(), c31 = _mm256_setzero_si256();
+    __m256i c40 = _mm256_setzero_si256(), c41 = _mm256_setzero_si256();
+    __m256i c50 = _mm256_setzero_si256(), c51 = _mm256_setzero_si256();
+
+#define MATRIX_AVX2_ROW(r)                                              \
+    a = _mm256_set1_epi32(Ap[r]);                                       \
+    c##r##0 = _mm256_add_epi32(c##r##0, _mm256_mullo_epi32(a, b0));     \
+    c##r##1 = _mm256_add_epi32(c##r##1, _mm256_mullo_epi32(a, b1));
+
+    for (int p = 0; p < kc; p++) {
+        const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Bp));
+        const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Bp + 8));
+        __m256i a;
+        MATRIX_AVX2_ROW(0)
+        MATRIX_AVX2_ROW(1)
+        MATRIX_AVX2_ROW(2)
+        MATRIX_AVX2_ROW(3)
+        MATRIX_AVX2_ROW(4)
+        MATRIX_AVX2_ROW(5)
+        Ap += 6;
+        Bp += 16;
+    }
+#undef MATRIX_AVX2_ROW
+
+    __m256i acc[6][2] = { {c00, c01}, {c10, c11}, {c20, c21}, {c30, c31}, {c40, c41}, {c50, c51} };
+    for (int r = 0; r < 6; r++) {
+        __m256i* c0 = reinterpret_cast<__m256i*>(C + r * ldc);
+        __m256i* c1 = reinterpret_cast<__m256i*>(C + r * ldc + 8);
+        if (accumulate) {
+            acc[r][0] = _mm256_add_epi32(acc[r][0], _mm256_loadu_si256(c0));
+            acc[r][1] = _mm256_add_epi32(acc[r][1], _mm256_loadu_si256(c1));
+        }
+        _mm256_storeu_si256(c0, acc[r][0]);
+        _mm256_storeu_si256(c1, acc[r][1]);
+    }
+}
@@ -0,0 +1,50 @@
+// Собирается с -mavx512f (/arch:AVX512). Не использовать здесь inline-функции и шаблоны из общих
+// заголовков: их экземпляры с AVX-512-инструкциями могут попасть в код, работающий на любом процессоре.
+#include "MicroKernels.h"
+#include <immintrin.h>
+
+// Блок 8 x 32: 16 накопителей по 16 int32, две загрузки B и одна рассылка A на каждый шаг k
+void microKernelAvx512(int kc, const int* Ap, const int* Bp, int* C, std::ptrdiff_t ldc, bool accumulate) {
+    __m512i c00 = _mm512_setzero_si512(), c01 = _mm512_setzero_si512();
+    __m512i c10 = _mm512_setzero_si512(), c11 = _mm512_setzero_si512();
+    __m512i c20 = _mm512_setzero_si512(), c21 = _mm512_setzero_si512();
+    __m512i c30 = _mm512_setzero_si512(), c31 = _mm512_setzero_si512();
+    __m512i c40 = _mm512_setzero_si512(), c41 = _mm512_setzero_si512();
+    __m512i c50 = _mm512_setzero_si512(), c51 = _mm512_setzero_si512();
+    __m512i c60 = _mm512_setzero_si512(), c61 = _mm512_setzero_si512();
+    __m512i c70 = _mm512_setzero_si512(), c71 = _mm512_setzero_si512();
+
+#define MATRIX_AVX512_ROW(r)                                            \
+    a = _mm512_set1_epi32(Ap[r]);                                       \
+    c##r##0 = _mm512_add_epi32(c##r##0, _mm512_mullo_epi32(a, b0));     \
+    c##r##1 = _mm512_add_epi32(c##r##1, _mm512_mullo_epi32(a, b1));
+
+    for (int p = 0; p < kc; p++) {
+        const __m512i b0 = _mm512_loadu_si512(Bp);
+        const __m512i b1 = _mm512_loadu_si512(Bp + 16);
+        __m512i a;
+        MATRIX_AVX512_ROW(0)
+        MATRIX_AVX512_ROW(1)
+        MATRIX_AVX512_ROW(2)
+        MATRIX_AVX512_ROW(3)
+        MATRIX_AVX512_ROW(4)
+        MATRIX_AVX512_ROW(5)
+        MATRIX_AVX512_ROW(6)
+        MATRIX_AVX512_ROW(7)
+        Ap += 8;
+        Bp += 32;
+    }
+#undef MATRIX_AVX512_ROW
+
+    __m512i acc[8][2] = { {c00, c01}, {c10, c11}, {c20, c21}, {c30, c31},
+                          {c40, c41}, {c50, c51}, {c60, c61}, {c70, c71} };
+    for (int r = 0; r < 8; r++) {
+        int* c = C + r * ldc;
+        if (accumulate) {
+            acc[r][0] = _mm512_add_epi32(acc[r][0], _mm512_loadu_si512(c));
+            acc[r][1] = _mm512_add_epi32(acc[r][1], _mm512_loadu_si512(c + 16));
+        }
+        _mm512_storeu_si512(c, acc[r][0]);
+        _mm512_storeu_si512(c + 16, acc[r][1]);
+    }
+}
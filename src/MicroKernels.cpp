@@ -0,0 +1,149 @@
+#include "MicroKernels.h"
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#if defined(MATRIX_X86_KERNELS) && defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(MATRIX_X86_KERNELS)
+#include <cpuid.h>
+#endif
+
+// Переносимый блок 4 x 8: компилятор сам векторизует внутренний цикл, если умеет
+void microKernelScalar(int kc, const int* Ap, const int* Bp, int* C, std::ptrdiff_t ldc, bool accumulate) {
+    int acc[4][8] = {};
+    for (int p = 0; p < kc; p++) {
+        for (int r = 0; r < 4; r++) {
+            const int a = Ap[r];
+            #pragma omp simd
+            for (int c = 0; c < 8; c++) {
+                acc[r][c] += a * Bp[c];
+            }
+        }
+        Ap += 4;
+        Bp += 8;
+    }
+    for (int r = 0; r < 4; r++) {
+        int* c = C + r * ldc;
+        for (int j = 0; j < 8; j++) {
+            c[j] = accumulate ? c[j] + acc[r][j] : acc[r][j];
+        }
+    }
+}
+
+namespace {
+
+const MicroKernel SCALAR_KERNEL = { "scalar", 4, 8, microKernelScalar };
+#ifdef MATRIX_X86_KERNELS
+const MicroKernel AVX2_KERNEL = { "avx2", 6, 16, microKernelAvx2 };
+const MicroKernel AVX512_KERNEL = { "avx512", 8, 32, microKernelAvx512 };
+#endif
+
+CpuFeatures detectFeatures() {
+    CpuFeatures features;
+#ifdef MATRIX_X86_KERNELS
+#ifdef _MSC_VER
+    // Флаги CPUID и проверка того, что ОС сохраняет регистры YMM (XCR0 & 0x6) и ZMM (XCR0 & 0xE6)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return features;
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0) return features;
+    const unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    const bool ymm = (xcr0 & 0x6) == 0x6;
+    const bool zmm = (xcr0 & 0xE6) == 0xE6;
+    features.avx2 = ymm && (info[1] & (1 << 5)) != 0;
+    features.avx512f = zmm && (info[1] & (1 << 16)) != 0;
+    features.avx512bw = features.avx512f && (info[1] & (1 << 30)) != 0;
+    features.avx512vnni = features.avx512f && (info[2] & (1 << 11)) != 0;
+#else
+    features.avx2 = __builtin_cpu_supports("avx2");
+    features.avx512f = __builtin_cpu_supports("avx512f");
+    features.avx512bw = __builtin_cpu_supports("avx512bw");
+    features.avx512vnni = __builtin_cpu_supports("avx512vnni");
+#endif
+#endif
+    return features;
+}
+
+std::vector<const MicroKernel*> detectKernels() {
+    std::vector<const MicroKernel*> kernels;
+#ifdef MATRIX_X86_KERNELS
+    if (cpuFeatures().avx512f) kernels.push_back(&AVX512_KERNEL);
+    if (cpuFeatures().avx2) kernels.push_back(&AVX2_KERNEL);
+#endif
+    kernels.push_back(&SCALAR_KERNEL);
+    return kernels;
+}
+
+const std::vector<const MicroKernel*>& supportedKernels() {
+    static const std::vector<const MicroKernel*> kernels = detectKernels();
+    return kernels;
+}
+
+std::atomic<const MicroKernel*>& activeKernelSlot() {
+    static std::atomic<const MicroKernel*> active(supportedKernels().front());
+    return active;
+}
+
+} // namespace
+
+const CpuFeatures& cpuFeatures() {
+    static const CpuFeatures features = detectFeatures();
+    return features;
+}
+
+std::string cpuModelName() {
+    std::string name;
+#ifdef MATRIX_X86_KERNELS
+    unsigned int regs[12] = {};
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0x80000000);
+    if (static_cast<unsigned int>(info[0]) >= 0x80000004) {
+        for (int leaf = 0; leaf < 3; leaf++) {
+            __cpuid(reinterpret_cast<int*>(regs + 4 * leaf), 0x80000002 + leaf);
+        }
+    }
+#else
+    if (__get_cpuid_max(0x80000000, nullptr) >= 0x80000004) {
+        for (unsigned int leaf = 0; leaf < 3; leaf++) {
+            __get_cpuid(0x80000002 + leaf, regs + 4 * leaf, regs + 4 * leaf + 1, regs + 4 * leaf + 2, regs + 4 * leaf + 3);
+        }
+    }
+#endif
+    char brand[sizeof(regs) + 1] = {};
+    std::memcpy(brand, regs, sizeof(regs));
+    name = brand;
+#else
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.rfind("model name", 0) == 0 && line.find(':') != std::string::npos) {
+            name = line.substr(line.find(':') + 1);
+            break;
+        }
+    }
+#endif
+    const std::size_t first = name.find_first_not_of(" \t");
+    const std::size_t last = name.find_last_not_of(" \t");
+    return first == std::string::npos ? "unknown" : name.substr(first, last - first + 1);
+}
+
+const MicroKernel& activeMicroKernel() {
+    return *activeKernelSlot().load(std::memory_order_relaxed);
+}
+
+std::vector<const MicroKernel*> availableMicroKernels() {
+    return supportedKernels();
+}
+
+bool setActiveMicroKernel(const std::string& name) {
+    for (const MicroKernel* kernel : supportedKernels()) {
+        if (name == kernel->name) {
+            activeKernelSlot().store(kernel, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,64 @@
+// Собирается с -mavx2 (/arch:AVX2). Не использовать здесь inline-функции и шаблоны из общих
+// заголовков: их экземпляры с AVX2-инструкциями могут попасть в код, работающий на любом процессоре.
+#include "NarrowKernels.h"
+#include <immintrin.h>
+
+namespace {
+
+// R строк результата на панель из 16 столбцов: pmaddwd перемножает пары int16 по k
+// и складывает их в int32, так что одна инструкция выполняет два шага по k для 8 столбцов
+template <int R>
+void rowsPanel(const std::int16_t* A, std::ptrdiff_t lda, const std::int16_t* panel, int kpairs,
+    int* out, std::ptrdiff_t ldo) {
+    __m256i acc0[R], acc1[R];
+    for (int r = 0; r < R; r++) {
+        acc0[r] = _mm256_setzero_si256();
+        acc1[r] = _mm256_setzero_si256();
+    }
+    for (int kp = 0; kp < kpairs; kp++) {
+        const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(panel + kp * 32));
+        const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(panel + kp * 32 + 16));
+        for (int r = 0; r < R; r++) {
+            const std::int16_t* pair = A + r * lda + 2 * kp;
+            const int packed = static_cast<int>(static_cast<std::uint16_t>(pair[0]) |
+                (static_cast<std::uint32_t>(static_cast<std::uint16_t>(pair[1])) << 16));
+            const __m256i a = _mm256_set1_epi32(packed);
+            acc0[r] = _mm256_add_epi32(acc0[r], _mm256_madd_epi16(a, b0));
+            acc1[r] = _mm256_add_epi32(acc1[r], _mm256_madd_epi16(a, b1));
+        }
+    }
+    for (int r = 0; r < R; r++) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + r * ldo), acc0[r]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + r * ldo + 8), acc1[r]);
+    }
+}
+
+} // namespace
+
+void narrowKernelInt16Avx2(const std::int16_t* A, std::ptrdiff_t lda, int rows, const std::int16_t* Bp,
+    int kpairs, int n, int* C, std::ptrdiff_t ldc) {
+    alignas(32) int edge[4 * 16];
+    for (int j0 = 0; j0 < n; j0 += 16) {
+        const int cols = n - j0 < 16 ? n - j0 : 16;
+        const std::int16_t* panel = Bp + static_cast<std::ptrdiff_t>(j0 / 16) * kpairs * 32;
+        for (int i0 = 0; i0 < rows; i0 += 4) {
+            const int r = rows - i0 < 4 ? rows - i0 : 4;
+            const std::int16_t* a = A + i0 * lda;
+            int* out = cols == 16 ? C + i0 * ldc + j0 : edge;
+            const std::ptrdiff_t ldo = cols == 16 ? ldc : 16;
+            switch (r) {
+            case 4: rowsPanel<4>(a, lda, panel, kpairs, out, ldo); break;
+            case 3: rowsPanel<3>(a, lda, panel, kpairs, out, ldo); break;
+            case 2: rowsPanel<2>(a, lda, panel, kpairs, out, ldo); break;
+            default: rowsPanel<1>(a, lda, panel, kpairs, out, ldo); break;
+            }
+            if (cols != 16) {
+                for (int i = 0; i < r; i++) {
+                    for (int j = 0; j < cols; j++) {
+                        C[(i0 + i) * ldc + j0 + j] = edge[i * 16 + j];
+                    }
+                }
+            }
+        }
+    }
+}
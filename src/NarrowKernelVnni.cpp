@@ -0,0 +1,67 @@
+// Собирается с -mavx512f -mavx512bw -mavx512vnni (/arch:AVX512). Не использовать здесь inline-функции
+// и шаблоны из общих заголовков: их экземпляры могут попасть в код, работающий на любом процессоре.
+#include "NarrowKernels.h"
+#include <immintrin.h>
+
+namespace {
+
+// R строк результата на панель из 32 столбцов: vpdpbusd перемножает четвёрки байтов
+// (A без знака, B со знаком) и прибавляет их сумму к int32, т.е. выполняет 4 шага по k за раз.
+// A хранится со сдвигом +128, вклад сдвига (128 * сумма столбца B) вычитается в конце.
+template <int R>
+void rowsPanel(const std::uint8_t* A, std::ptrdiff_t lda, const std::int8_t* panel, int kquads,
+    const int* correction, int* out, std::ptrdiff_t ldo) {
+    __m512i acc0[R], acc1[R];
+    for (int r = 0; r < R; r++) {
+        acc0[r] = _mm512_setzero_si512();
+        acc1[r] = _mm512_setzero_si512();
+    }
+    for (int kq = 0; kq < kquads; kq++) {
+        const __m512i b0 = _mm512_loadu_si512(panel + kq * 128);
+        const __m512i b1 = _mm512_loadu_si512(panel + kq * 128 + 64);
+        for (int r = 0; r < R; r++) {
+            const std::uint8_t* quad = A + r * lda + 4 * kq;
+            const std::uint32_t packed = quad[0] | (static_cast<std::uint32_t>(quad[1]) << 8) |
+                (static_cast<std::uint32_t>(quad[2]) << 16) | (static_cast<std::uint32_t>(quad[3]) << 24);
+            const __m512i a = _mm512_set1_epi32(static_cast<int>(packed));
+            acc0[r] = _mm512_dpbusd_epi32(acc0[r], a, b0);
+            acc1[r] = _mm512_dpbusd_epi32(acc1[r], a, b1);
+        }
+    }
+    const __m512i corr0 = _mm512_loadu_si512(correction);
+    const __m512i corr1 = _mm512_loadu_si512(correction + 16);
+    for (int r = 0; r < R; r++) {
+        _mm512_storeu_si512(out + r * ldo, _mm512_sub_epi32(acc0[r], corr0));
+        _mm512_storeu_si512(out + r * ldo + 16, _mm512_sub_epi32(acc1[r], corr1));
+    }
+}
+
+} // namespace
+
+void narrowKernelInt8Vnni(const std::uint8_t* A, std::ptrdiff_t lda, int rows, const std::int8_t* Bp,
+    int kquads, int n, const int* correction, int* C, std::ptrdiff_t ldc) {
+    alignas(64) int edge[4 * 32];
+    for (int j0 = 0; j0 < n; j0 += 32) {
+        const int cols = n - j0 < 32 ? n - j0 : 32;
+        const std::int8_t* panel = Bp + static_cast<std::ptrdiff_t>(j0 / 32) * kquads * 128;
+        for (int i0 = 0; i0 < rows; i0 += 4) {
+            const int r = rows - i0 < 4 ? rows - i0 : 4;
+            const std::uint8_t* a = A + i0 * lda;
+            int* out = cols == 32 ? C + i0 * ldc + j0 : edge;
+            const std::ptrdiff_t ldo = cols == 32 ? ldc : 32;
+            switch (r) {
+            case 4: rowsPanel<4>(a, lda, panel, kquads, correction + j0, out, ldo); break;
+            case 3: rowsPanel<3>(a, lda, panel, kquads, correction + j0, out, ldo); break;
+            case 2: rowsPanel<2>(a, lda, panel, kquads, correction + j0, out, ldo); break;
+            default: rowsPanel<1>(a, lda, panel, kquads, correction + j0, out, ldo); break;
+            }
+            if (cols != 32) {
+                for (int i = 0; i < r; i++) {
+                    for (int j = 0; j < cols; j++) {
+                        C[(i0 + i) * ldc + j0 + j] = edge[i * 32 + j];
+                    }
+                }
+            }
+        }
+    }
+}
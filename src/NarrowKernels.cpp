@@ -0,0 +1,194 @@
+#include "NarrowKernels.h"
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+#include <omp.h>
+#include "MicroKernels.h"
+
+namespace {
+
+// Строк результата на одну порцию работы потока в векторизованных ядрах
+constexpr int ROW_BLOCK = 32;
+
+template <typename TIn>
+void checkOperands(MatrixView<TIn> A, MatrixView<TIn> B) {
+    if (A.cols() != B.rows()) {
+        throw std::invalid_argument("multiplyNarrowKernel: число столбцов A не равно числу строк B");
+    }
+}
+
+// Переносимое ядро: порядок i-k-j, каждый элемент расширяется до TAcc перед умножением
+template <typename TIn, typename TAcc>
+void genericKernel(MatrixView<TIn> A, MatrixView<TIn> B, TAcc* C, std::ptrdiff_t ldc, int num_threads) {
+    const int m = A.rows(), n = B.cols(), k = A.cols();
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for (int i = 0; i < m; i++) {
+        TAcc* c = C + i * ldc;
+        std::fill(c, c + n, TAcc(0));
+        const TIn* a = A.row(i);
+        for (int p = 0; p < k; p++) {
+            const TAcc ap = a[p];
+            const TIn* b = B.row(p);
+            #pragma omp simd
+            for (int j = 0; j < n; j++) {
+                c[j] += ap * static_cast<TAcc>(b[j]);
+            }
+        }
+    }
+}
+
+#ifdef MATRIX_X86_KERNELS
+// int16 (или int8, расширенный до int16) -> int32 через pmaddwd. B упаковывается в панели
+// по 16 столбцов, внутри панели для каждой пары k лежат 16 пар (B[2kp][j], B[2kp+1][j]).
+// A копируется с выравниванием k до чётного, дополнение - нули.
+template <typename TIn>
+void pairedAvx2Kernel(MatrixView<TIn> A, MatrixView<TIn> B, int* C, std::ptrdiff_t ldc, int num_threads) {
+    const int m = A.rows(), n = B.cols(), k = A.cols();
+    const int kpairs = (k + 1) / 2;
+    const int panels = (n + 15) / 16;
+    AlignedMatrix<std::int16_t> Ap(m, 2 * kpairs);
+    AlignedMatrix<std::int16_t> Bp(1, panels * kpairs * 32);
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        #pragma omp for schedule(static)
+        for (int jb = 0; jb < panels; jb++) {
+            std::int16_t* panel = Bp.data() + static_cast<std::ptrdiff_t>(jb) * kpairs * 32;
+            for (int p = 0; p < k; p++) {
+                const TIn* b = B.row(p);
+                for (int col = 0; col < 16 && jb * 16 + col < n; col++) {
+                    panel[(p / 2) * 32 + col * 2 + p % 2] = b[jb * 16 + col];
+                }
+            }
+        }
+        #pragma omp for schedule(static)
+        for (int i = 0; i < m; i++) {
+            std::copy(A.row(i), A.row(i) + k, Ap.row(i));
+        }
+        #pragma omp for schedule(static)
+        for (int i0 = 0; i0 < m; i0 += ROW_BLOCK) {
+            narrowKernelInt16Avx2(Ap.row(i0), Ap.ld(), std::min(ROW_BLOCK, m - i0), Bp.data(), kpairs, n,
+                C + i0 * ldc, ldc);
+        }
+    }
+}
+
+// int8 -> int32 через vpdpbusd. B упаковывается в панели по 32 столбца с четвёрками по k,
+// A сдвигается на +128 в беззнаковый диапазон, поправка 128 * сумма столбца B вычитается в ядре.
+void quadVnniKernel(MatrixView<std::int8_t> A, MatrixView<std::int8_t> B, int* C, std::ptrdiff_t ldc,
+    int num_threads) {
+    const int m = A.rows(), n = B.cols(), k = A.cols();
+    const int kquads = (k + 3) / 4;
+    const int panels = (n + 31) / 32;
+    AlignedMatrix<std::uint8_t> Ap(m, 4 * kquads);
+    AlignedMatrix<std::int8_t> Bp(1, panels * kquads * 128);
+    std::vector<int> correction(static_cast<std::size_t>(panels) * 32, 0);
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        #pragma omp for schedule(static)
+        for (int jb = 0; jb < panels; jb++) {
+            std::int8_t* panel = Bp.data() + static_cast<std::ptrdiff_t>(jb) * kquads * 128;
+            for (int p = 0; p < k; p++) {
+                const std::int8_t* b = B.row(p);
+                for (int col = 0; col < 32 && jb * 32 + col < n; col++) {
+                    panel[(p / 4) * 128 + col * 4 + p % 4] = b[jb * 32 + col];
+                    correction[jb * 32 + col] += 128 * b[jb * 32 + col];
+                }
+            }
+        }
+        #pragma omp for schedule(static)
+        for (int i = 0; i < m; i++) {
+            const std::int8_t* a = A.row(i);
+            std::uint8_t* dst = Ap.row(i);
+            for (int p = 0; p < k; p++) {
+                dst[p] = static_cast<std::uint8_t>(a[p] + 128);
+            }
+        }
+        #pragma omp for schedule(static)
+        for (int i0 = 0; i0 < m; i0 += ROW_BLOCK) {
+            narrowKernelInt8Vnni(Ap.row(i0), Ap.ld(), std::min(ROW_BLOCK, m - i0), Bp.data(), kquads, n,
+                correction.data(), C + i0 * ldc, ldc);
+        }
+    }
+}
+#endif
+
+} // namespace
+
+template <typename TIn, typename TAcc>
+void multiplyNarrowKernel(MatrixView<TIn> A, MatrixView<TIn> B, TAcc* C, std::ptrdiff_t ldc, int num_threads) {
+    checkOperands(A, B);
+#ifdef MATRIX_X86_KERNELS
+    if constexpr (std::is_same<TAcc, std::int32_t>::value && sizeof(TIn) <= 2) {
+        if constexpr (std::is_same<TIn, std::int8_t>::value) {
+            if (cpuFeatures().avx512vnni && cpuFeatures().avx512bw) {
+                quadVnniKernel(A, B, C, ldc, num_threads);
+                return;
+            }
+        }
+        if (cpuFeatures().avx2) {
+            pairedAvx2Kernel(A, B, C, ldc, num_threads);
+            return;
+        }
+    }
+#endif
+    genericKernel(A, B, C, ldc, num_threads);
+}
+
+template <typename TIn>
+void multiplyCheckedKernel(MatrixView<TIn> A, MatrixView<TIn> B, int* C, std::ptrdiff_t ldc, int num_threads) {
+    checkOperands(A, B);
+    const int m = A.rows(), n = B.cols(), k = A.cols();
+    bool overflow = false;
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        std::vector<std::int64_t> acc(n);
+        #pragma omp for schedule(static) reduction(||: overflow)
+        for (int i = 0; i < m; i++) {
+            std::fill(acc.begin(), acc.end(), 0);
+            const TIn* a = A.row(i);
+            for (int p = 0; p < k; p++) {
+                const std::int64_t ap = a[p];
+                const TIn* b = B.row(p);
+                std::int64_t* s = acc.data();
+                #pragma omp simd
+                for (int j = 0; j < n; j++) {
+                    s[j] += ap * b[j];
+                }
+            }
+            int* c = C + i * ldc;
+            for (int j = 0; j < n; j++) {
+                if (acc[j] < std::numeric_limits<int>::min() || acc[j] > std::numeric_limits<int>::max()) {
+                    overflow = true;
+                }
+                c[j] = static_cast<int>(acc[j]);
+            }
+        }
+    }
+
+    if (overflow) {
+        throw std::overflow_error("multiplyCheckedKernel: элемент результата не помещается в int");
+    }
+}
+
+template void multiplyNarrowKernel<std::int8_t, std::int32_t>(MatrixView<std::int8_t>, MatrixView<std::int8_t>,
+    std::int32_t*, std::ptrdiff_t, int);
+template void multiplyNarrowKernel<std::int8_t, std::int64_t>(MatrixView<std::int8_t>, MatrixView<std::int8_t>,
+    std::int64_t*, std::ptrdiff_t, int);
+template void multiplyNarrowKernel<std::int16_t, std::int32_t>(MatrixView<std::int16_t>, MatrixView<std::int16_t>,
+    std::int32_t*, std::ptrdiff_t, int);
+template void multiplyNarrowKernel<std::int16_t, std::int64_t>(MatrixView<std::int16_t>, MatrixView<std::int16_t>,
+    std::int64_t*, std::ptrdiff_t, int);
+template void multiplyNarrowKernel<std::int32_t, std::int32_t>(MatrixView<std::int32_t>, MatrixView<std::int32_t>,
+    std::int32_t*, std::ptrdiff_t, int);
+template void multiplyNarrowKernel<std::int32_t, std::int64_t>(MatrixView<std::int32_t>, MatrixView<std::int32_t>,
+    std::int64_t*, std::ptrdiff_t, int);
+
+template void multiplyCheckedKernel<std::int8_t>(MatrixView<std::int8_t>, MatrixView<std::int8_t>,
+    int*, std::ptrdiff_t, int);
+template void multiplyCheckedKernel<std::int16_t>(MatrixView<std::int16_t>, MatrixView<std::int16_t>,
+    int*, std::ptrdiff_t, int);
+template void multiplyCheckedKernel<std::int32_t>(MatrixView<std::int32_t>, MatrixView<std::int32_t>,
+    int*, std::ptrdiff_t, int);
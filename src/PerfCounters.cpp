@@ -0,0 +1,139 @@
+#include "PerfCounters.h"
+#include <cstdint>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Поля PerfCounts в порядке открытия событий
+long long PerfCounts::* const FIELDS[] = {
+    &PerfCounts::cycles, &PerfCounts::instructions, &PerfCounts::l1dMisses,
+    &PerfCounts::llcMisses, &PerfCounts::dtlbMisses };
+constexpr int EVENT_COUNT = sizeof(FIELDS) / sizeof(FIELDS[0]);
+
+#ifdef __linux__
+
+struct EventSpec {
+    std::uint32_t type;
+    std::uint64_t config;
+};
+
+constexpr std::uint64_t cacheMiss(std::uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+const EventSpec EVENTS[EVENT_COUNT] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_L1D) },
+    { PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_LL) },
+    { PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_DTLB) },
+};
+
+// Счётчики одного потока: события открываются по отдельности, чтобы недоступное событие
+// (например, LLC в виртуальной машине) не отключало остальные
+struct ThreadCounters {
+    int fds[EVENT_COUNT];
+    bool opened = false;
+
+    ThreadCounters() {
+        for (int& fd : fds) fd = -1;
+    }
+
+    ~ThreadCounters() {
+        for (int fd : fds) {
+            if (fd >= 0) close(fd);
+        }
+    }
+
+    void open() {
+        if (opened) return;
+        opened = true;
+        for (int e = 0; e < EVENT_COUNT; e++) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = EVENTS[e].type;
+            attr.config = EVENTS[e].config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds[e] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+    }
+};
+
+thread_local ThreadCounters counters;
+
+#endif
+
+} // namespace
+
+bool PerfCounts::available() const {
+    for (auto field : FIELDS) {
+        if (this->*field >= 0) return true;
+    }
+    return false;
+}
+
+double PerfCounts::ipc() const {
+    return cycles > 0 && instructions >= 0 ? static_cast<double>(instructions) / cycles : 0;
+}
+
+PerfCounts& PerfCounts::operator+=(const PerfCounts& other) {
+    for (auto field : FIELDS) {
+        if (other.*field < 0) continue;
+        this->*field = (this->*field < 0 ? 0 : this->*field) + other.*field;
+    }
+    return *this;
+}
+
+PerfCounts PerfReport::total() const {
+    PerfCounts sum;
+    for (const auto& counts : threads) sum += counts;
+    return sum;
+}
+
+void perfThreadStart() {
+#ifdef __linux__
+    counters.open();
+    for (int fd : counters.fds) {
+        if (fd < 0) continue;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+PerfCounts perfThreadStop() {
+    PerfCounts counts;
+#ifdef __linux__
+    for (int e = 0; e < EVENT_COUNT; e++) {
+        const int fd = counters.fds[e];
+        if (fd < 0) continue;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        // value, time_enabled, time_running
+        std::uint64_t data[3] = {};
+        if (read(fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) continue;
+        const double scale = data[2] > 0 ? static_cast<double>(data[1]) / static_cast<double>(data[2]) : 1.0;
+        counts.*FIELDS[e] = static_cast<long long>(static_cast<double>(data[0]) * scale);
+    }
+#endif
+    return counts;
+}
+
+bool perfCountersAvailable() {
+#ifdef __linux__
+    counters.open();
+    for (int fd : counters.fds) {
+        if (fd >= 0) return true;
+    }
+#endif
+    return false;
+}
@@ -0,0 +1,44 @@
+#include "Random.h"
+#include <omp.h>
+
+namespace {
+
+// Меньшие матрицы заполняются одним потоком: запуск команды дороже самой работы
+constexpr std::size_t PARALLEL_MIN_ELEMENTS = 1 << 16;
+
+} // namespace
+
+void fillRandom(AlignedMatrix<int>& m, std::uint64_t seed, std::uint64_t stream, int lo, int hi,
+    double density) {
+    const std::uint64_t key = counterRandom(seed, stream);
+    // Позиция остаётся ненулевой, если её 53-битная доля из отдельного потока меньше density
+    const std::uint64_t maskKey = counterRandom(~seed, stream);
+    const bool sparse = density < 1.0;
+    const int rows = m.rows(), cols = m.cols();
+    const std::ptrdiff_t ld = m.ld();
+    int* data = m.data();
+
+    #pragma omp parallel for schedule(static) if (m.storageSize() >= PARALLEL_MIN_ELEMENTS)
+    for (int i = 0; i < rows; i++) {
+        int* row = data + i * ld;
+        const std::uint64_t base = static_cast<std::uint64_t>(i) * cols;
+        for (int j = 0; j < cols; j++) {
+            const bool keep = !sparse || (counterRandom(maskKey, base + j) >> 11) * 0x1.0p-53 < density;
+            row[j] = keep ? counterUniform(key, base + j, lo, hi) : 0;
+        }
+        for (std::ptrdiff_t j = cols; j < ld; j++) {
+            row[j] = 0;
+        }
+    }
+}
+
+void firstTouchZero(AlignedMatrix<int>& m) {
+    const int rows = m.rows();
+    const std::ptrdiff_t ld = m.ld();
+    int* data = m.data();
+
+    #pragma omp parallel for schedule(static) if (m.storageSize() >= PARALLEL_MIN_ELEMENTS)
+    for (int i = 0; i < rows; i++) {
+        std::fill(data + i * ld, data + (i + 1) * ld, 0);
+    }
+}
@@ -0,0 +1,125 @@
+#include "ResultCache.h"
+#include <vector>
+#include <omp.h>
+#include "Random.h"
+
+namespace {
+
+// Ключи NH двух половин хеша
+constexpr std::uint64_t KEY_LOW = 0x243F6A8885A308D3ULL;
+constexpr std::uint64_t KEY_HIGH = 0x13198A2E03707344ULL;
+
+std::vector<std::uint32_t> nhKey(std::uint64_t seed, int length) {
+    std::vector<std::uint32_t> key(length);
+    for (int j = 0; j < length; j++) key[j] = static_cast<std::uint32_t>(counterRandom(seed, j) >> 32);
+    return key;
+}
+
+// NH строки: элемент j в паре с j + half, обе половины читаются подряд; нечётный последний
+// элемент - в паре с дополнительным словом ключа
+std::uint64_t nh(const int* row, const std::uint32_t* key, int cols) {
+    const int half = cols / 2;
+    std::uint64_t sum = 0;
+    #pragma omp simd reduction(+ : sum)
+    for (int j = 0; j < half; j++) {
+        const std::uint32_t x = static_cast<std::uint32_t>(row[j]) + key[j];
+        const std::uint32_t y = static_cast<std::uint32_t>(row[j + half]) + key[j + half];
+        sum += static_cast<std::uint64_t>(x) * y;
+    }
+    if (cols % 2) {
+        sum += static_cast<std::uint64_t>(static_cast<std::uint32_t>(row[cols - 1]) + key[cols - 1]) * key[cols];
+    }
+    return sum;
+}
+
+} // namespace
+
+MatrixHash hashMatrix(MatrixView<int> m, int num_threads) {
+    const int rows = m.rows();
+    const int cols = m.cols();
+    const std::vector<std::uint32_t> keyLow = nhKey(KEY_LOW, cols + 1);
+    const std::vector<std::uint32_t> keyHigh = nhKey(KEY_HIGH, cols + 1);
+
+    // Сумма перемешанных хешей строк не зависит от порядка сложения, поэтому строки делятся между потоками
+    std::uint64_t low = 0, high = 0;
+    #pragma omp parallel for reduction(+ : low, high) num_threads(num_threads) schedule(static)
+    for (int i = 0; i < rows; i++) {
+        low += counterRandom(nh(m.row(i), keyLow.data(), cols), i);
+        high += counterRandom(nh(m.row(i), keyHigh.data(), cols), i);
+    }
+    const std::uint64_t shape = (static_cast<std::uint64_t>(rows) << 32) | static_cast<std::uint32_t>(cols);
+    return { counterRandom(low, shape), counterRandom(high ^ KEY_HIGH, shape) };
+}
+
+bool ResultKey::operator==(const ResultKey& other) const {
+    return a == other.a && b == other.b && m == other.m && n == other.n && k == other.k
+        && opA == other.opA && opB == other.opB && type == other.type && accumulation == other.accumulation;
+}
+
+double CacheStats::hitRate() const {
+    const long long total = hits + misses;
+    return total > 0 ? static_cast<double>(hits) / total : 0;
+}
+
+ResultCache::ResultCache(std::size_t budgetBytes) : budgetBytes(budgetBytes) {}
+
+std::shared_ptr<const AlignedMatrix<int>> ResultCache::find(const ResultKey& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = index.find(key);
+    if (found == index.end()) {
+        counters.misses++;
+        return nullptr;
+    }
+    counters.hits++;
+    entries.splice(entries.begin(), entries, found->second);
+    return found->second->C;
+}
+
+void ResultCache::insert(const ResultKey& key, MatrixView<int> C) {
+    const std::size_t size = static_cast<std::size_t>(C.rows()) * AlignedMatrix<int>::paddedLeadingDimension(C.cols())
+        * sizeof(int);
+    if (size > budgetBytes) return;
+    // Копия делается вне блокировки: одновременные промахи других потоков её не ждут
+    auto copy = std::make_shared<const AlignedMatrix<int>>(AlignedMatrix<int>::adopt(const_cast<int*>(C.data()),
+        C.rows(), C.cols(), C.ld()));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = index.find(key);
+    if (found != index.end()) {
+        entries.splice(entries.begin(), entries, found->second);
+        return;
+    }
+    while (counters.bytes + size > budgetBytes) {
+        counters.bytes -= entries.back().C->sizeBytes();
+        index.erase(entries.back().key);
+        entries.pop_back();
+        counters.evictions++;
+    }
+    entries.push_front({ key, std::move(copy) });
+    index[key] = entries.begin();
+    counters.bytes += size;
+}
+
+void ResultCache::recordHashing(double seconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.hashSeconds += seconds;
+}
+
+void ResultCache::recordMultiply(double seconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.missSeconds += seconds;
+}
+
+CacheStats ResultCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    CacheStats result = counters;
+    result.entries = entries.size();
+    return result;
+}
+
+void ResultCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+    counters.bytes = 0;
+}
@@ -0,0 +1,195 @@
+#include "Sparse.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <omp.h>
+
+namespace {
+
+// Стоимость строк разреженного операнда неравномерна: строки раздаются порциями по требованию
+constexpr int ROW_CHUNK = 16;
+// Строк A в панели spmm плотная x CSC: транспонированная панель и столбцы результата
+// длиной PANEL помещаются в L2
+constexpr int PANEL = 64;
+
+void checkOperands(const char* kernel, int colsA, int rowsB) {
+    if (colsA != rowsB) {
+        throw std::invalid_argument(std::string(kernel) + ": число столбцов A не равно числу строк B");
+    }
+}
+
+// c[j] += a * b(p, j) по ненулевым элементам строки p матрицы B
+void addSparseRow(const CsrMatrix& B, int p, int a, int* c) {
+    for (std::size_t e = B.rowPtr[p]; e < B.rowPtr[p + 1]; e++) {
+        c[B.colIdx[e]] += a * B.values[e];
+    }
+}
+
+} // namespace
+
+CsrMatrix CsrMatrix::fromDense(MatrixView<int> dense, int num_threads) {
+    CsrMatrix csr;
+    csr.rows = dense.rows();
+    csr.cols = dense.cols();
+    csr.rowPtr.assign(static_cast<std::size_t>(csr.rows) + 1, 0);
+
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for (int i = 0; i < csr.rows; i++) {
+        const int* row = dense.row(i);
+        std::size_t count = 0;
+        for (int j = 0; j < csr.cols; j++) {
+            count += row[j] != 0;
+        }
+        csr.rowPtr[i + 1] = count;
+    }
+    for (int i = 0; i < csr.rows; i++) {
+        csr.rowPtr[i + 1] += csr.rowPtr[i];
+    }
+    csr.colIdx.resize(csr.rowPtr[csr.rows]);
+    csr.values.resize(csr.rowPtr[csr.rows]);
+
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for (int i = 0; i < csr.rows; i++) {
+        const int* row = dense.row(i);
+        std::size_t e = csr.rowPtr[i];
+        for (int j = 0; j < csr.cols; j++) {
+            if (row[j] != 0) {
+                csr.colIdx[e] = j;
+                csr.values[e] = row[j];
+                e++;
+            }
+        }
+    }
+    return csr;
+}
+
+CscMatrix CscMatrix::fromDense(MatrixView<int> dense, int num_threads) {
+    CscMatrix csc;
+    csc.rows = dense.rows();
+    csc.cols = dense.cols();
+    csc.colPtr.assign(static_cast<std::size_t>(csc.cols) + 1, 0);
+
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for (int j = 0; j < csc.cols; j++) {
+        std::size_t count = 0;
+        for (int i = 0; i < csc.rows; i++) {
+            count += dense(i, j) != 0;
+        }
+        csc.colPtr[j + 1] = count;
+    }
+    for (int j = 0; j < csc.cols; j++) {
+        csc.colPtr[j + 1] += csc.colPtr[j];
+    }
+    csc.rowIdx.resize(csc.colPtr[csc.cols]);
+    csc.values.resize(csc.colPtr[csc.cols]);
+
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for (int j = 0; j < csc.cols; j++) {
+        std::size_t e = csc.colPtr[j];
+        for (int i = 0; i < csc.rows; i++) {
+            if (dense(i, j) != 0) {
+                csc.rowIdx[e] = i;
+                csc.values[e] = dense(i, j);
+                e++;
+            }
+        }
+    }
+    return csc;
+}
+
+double density(MatrixView<int> m, int num_threads) {
+    if (m.empty()) return 0;
+    long long nonzero = 0;
+    #pragma omp parallel for schedule(static) reduction(+ : nonzero) num_threads(num_threads)
+    for (int i = 0; i < m.rows(); i++) {
+        const int* row = m.row(i);
+        for (int j = 0; j < m.cols(); j++) {
+            nonzero += row[j] != 0;
+        }
+    }
+    return static_cast<double>(nonzero) / (static_cast<double>(m.rows()) * m.cols());
+}
+
+SparsePath chooseSparsePath(double densityA, double densityB, double threshold) {
+    const bool sparseA = densityA < threshold;
+    const bool sparseB = densityB < threshold;
+    if (sparseA && sparseB) return SparsePath::SparseAB;
+    if (sparseA) return SparsePath::SparseA;
+    if (sparseB) return SparsePath::SparseB;
+    return SparsePath::Dense;
+}
+
+void spmmKernel(MatrixView<int> A, const CscMatrix& B, int* C, std::ptrdiff_t ldc, int num_threads) {
+    checkOperands("spmmKernel", A.cols(), B.rows);
+    const int m = A.rows(), n = B.cols, k = A.cols();
+    const int panels = (m + PANEL - 1) / PANEL;
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        AlignedMatrix<int> At(k, PANEL);
+        AlignedMatrix<int> Ct(n, PANEL);
+
+        #pragma omp for schedule(dynamic)
+        for (int panel = 0; panel < panels; panel++) {
+            const int i0 = panel * PANEL;
+            const int rows = std::min(PANEL, m - i0);
+            for (int r = 0; r < rows; r++) {
+                const int* a = A.row(i0 + r);
+                for (int p = 0; p < k; p++) {
+                    At(p, r) = a[p];
+                }
+            }
+            for (int j = 0; j < n; j++) {
+                int* ct = Ct.row(j);
+                std::fill(ct, ct + PANEL, 0);
+                for (std::size_t e = B.colPtr[j]; e < B.colPtr[j + 1]; e++) {
+                    const int b = B.values[e];
+                    const int* at = At.row(B.rowIdx[e]);
+                    #pragma omp simd
+                    for (int r = 0; r < PANEL; r++) {
+                        ct[r] += b * at[r];
+                    }
+                }
+            }
+            for (int r = 0; r < rows; r++) {
+                int* c = C + (i0 + r) * ldc;
+                for (int j = 0; j < n; j++) {
+                    c[j] = Ct(j, r);
+                }
+            }
+        }
+    }
+}
+
+void spmmKernel(const CsrMatrix& A, MatrixView<int> B, int* C, std::ptrdiff_t ldc, int num_threads) {
+    checkOperands("spmmKernel", A.cols, B.rows());
+    const int m = A.rows, n = B.cols();
+
+    #pragma omp parallel for schedule(dynamic, ROW_CHUNK) num_threads(num_threads)
+    for (int i = 0; i < m; i++) {
+        int* c = C + i * ldc;
+        std::fill(c, c + n, 0);
+        for (std::size_t e = A.rowPtr[i]; e < A.rowPtr[i + 1]; e++) {
+            const int a = A.values[e];
+            const int* b = B.row(A.colIdx[e]);
+            #pragma omp simd
+            for (int j = 0; j < n; j++) {
+                c[j] += a * b[j];
+            }
+        }
+    }
+}
+
+void spgemmKernel(const CsrMatrix& A, const CsrMatrix& B, int* C, std::ptrdiff_t ldc, int num_threads) {
+    checkOperands("spgemmKernel", A.cols, B.rows);
+    const int m = A.rows, n = B.cols;
+
+    #pragma omp parallel for schedule(dynamic, ROW_CHUNK) num_threads(num_threads)
+    for (int i = 0; i < m; i++) {
+        int* c = C + i * ldc;
+        std::fill(c, c + n, 0);
+        for (std::size_t e = A.rowPtr[i]; e < A.rowPtr[i + 1]; e++) {
+            addSparseRow(B, A.colIdx[e], A.values[e], c);
+        }
+    }
+}
@@ -0,0 +1,130 @@
+#include "Kernels.h"
+#include <algorithm>
+#include <stdexcept>
+#include <omp.h>
+
+namespace {
+
+// Глубина рекурсии, до которой подзадачи выдаются как задачи OpenMP (7^3 = 343 задачи)
+constexpr int TASK_DEPTH = 3;
+
+struct Block {
+    const int* data;
+    std::ptrdiff_t ld;
+    const int* at(int i, int j) const { return data + i * ld + j; }
+};
+
+// Z = X + Y для блоков h x h
+void add(Block X, Block Y, int* Z, std::ptrdiff_t ldz, int h) {
+    for (int i = 0; i < h; i++) {
+        const int* x = X.data + i * X.ld;
+        const int* y = Y.data + i * Y.ld;
+        int* z = Z + i * ldz;
+        #pragma omp simd
+        for (int j = 0; j < h; j++) z[j] = x[j] + y[j];
+    }
+}
+
+// Z = X - Y для блоков h x h
+void sub(Block X, Block Y, int* Z, std::ptrdiff_t ldz, int h) {
+    for (int i = 0; i < h; i++) {
+        const int* x = X.data + i * X.ld;
+        const int* y = Y.data + i * Y.ld;
+        int* z = Z + i * ldz;
+        #pragma omp simd
+        for (int j = 0; j < h; j++) z[j] = x[j] - y[j];
+    }
+}
+
+Block block(const AlignedMatrix<int>& m) {
+    return Block{ m.data(), m.ld() };
+}
+
+// Рекурсивный шаг Штрассена-Винограда: 7 умножений и 15 сложений блоков размера n/2.
+// Ниже порога cutoff (или при нечётном n) используется блочное ядро.
+void strassen(Block A, Block B, int* C, std::ptrdiff_t ldc, int n, int cutoff, int depth) {
+    if (n <= cutoff || n % 2 != 0) {
+        multiplyBlockedKernel(MatrixView<int>(A.data, n, n, A.ld), MatrixView<int>(B.data, n, n, B.ld),
+            C, ldc, BlockSizes());
+        return;
+    }
+
+    const int h = n / 2;
+    const Block A11{ A.at(0, 0), A.ld }, A12{ A.at(0, h), A.ld }, A21{ A.at(h, 0), A.ld }, A22{ A.at(h, h), A.ld };
+    const Block B11{ B.at(0, 0), B.ld }, B12{ B.at(0, h), B.ld }, B21{ B.at(h, 0), B.ld }, B22{ B.at(h, h), B.ld };
+
+    AlignedMatrix<int> S1(h, h), S2(h, h), S3(h, h), S4(h, h);
+    AlignedMatrix<int> T1(h, h), T2(h, h), T3(h, h), T4(h, h);
+    add(A21, A22, S1.data(), S1.ld(), h);
+    sub(block(S1), A11, S2.data(), S2.ld(), h);
+    sub(A11, A21, S3.data(), S3.ld(), h);
+    sub(A12, block(S2), S4.data(), S4.ld(), h);
+    sub(B12, B11, T1.data(), T1.ld(), h);
+    sub(B22, block(T1), T2.data(), T2.ld(), h);
+    sub(B22, B12, T3.data(), T3.ld(), h);
+    sub(block(T2), B21, T4.data(), T4.ld(), h);
+
+    AlignedMatrix<int> M[7] = { {h, h}, {h, h}, {h, h}, {h, h}, {h, h}, {h, h}, {h, h} };
+    const Block left[7] = { A11, A12, block(S4), A22, block(S1), block(S2), block(S3) };
+    const Block right[7] = { B11, B21, B22, block(T4), block(T1), block(T2), block(T3) };
+
+    for (int t = 0; t < 7; t++) {
+        #pragma omp task if(depth < TASK_DEPTH) default(shared) firstprivate(t)
+        strassen(left[t], right[t], M[t].data(), M[t].ld(), h, cutoff, depth + 1);
+    }
+    #pragma omp taskwait
+
+    // C11 = M1 + M2, U2 = M1 + M6, U3 = U2 + M7, U4 = U2 + M5,
+    // C12 = U4 + M3, C21 = U3 - M4, C22 = U3 + M5. U2, U3 и U4 пишутся поверх M6 и M7.
+    add(block(M[0]), block(M[1]), C, ldc, h);
+    AlignedMatrix<int>& U2 = M[5];
+    add(block(M[0]), block(M[5]), U2.data(), U2.ld(), h);
+    AlignedMatrix<int>& U3 = M[6];
+    add(block(U2), block(M[6]), U3.data(), U3.ld(), h);
+    AlignedMatrix<int>& U4 = M[5];
+    add(block(U2), block(M[4]), U4.data(), U4.ld(), h);
+    add(block(U4), block(M[2]), C + h, ldc, h);
+    sub(block(U3), block(M[3]), C + h * ldc, ldc, h);
+    add(block(U3), block(M[4]), C + h * ldc + h, ldc, h);
+}
+
+} // namespace
+
+void multiplyStrassenKernel(MatrixView<int> A, MatrixView<int> B, int* C, std::ptrdiff_t ldc,
+    int cutoff, int num_threads) {
+    const int n = A.rows();
+    if (A.cols() != n || B.rows() != n || B.cols() != n) {
+        throw std::invalid_argument("multiplyStrassenKernel: операнды должны быть квадратными матрицами одного размера");
+    }
+    if (cutoff <= 0) {
+        throw std::invalid_argument("multiplyStrassenKernel: порог рекурсии должен быть положительным");
+    }
+
+    // Дополнение нулями до size * 2^levels, где size <= cutoff: все уровни делятся пополам без остатка
+    int levels = 0;
+    int size = n;
+    while (size > cutoff) {
+        size = (size + 1) / 2;
+        levels++;
+    }
+    const int padded = size << levels;
+
+    #pragma omp parallel num_threads(num_threads)
+    #pragma omp single
+    {
+        if (padded == n) {
+            strassen(Block{ A.data(), A.ld() }, Block{ B.data(), B.ld() }, C, ldc, n, cutoff, 0);
+        }
+        else {
+            AlignedMatrix<int> Ap(padded, padded), Bp(padded, padded), Cp(padded, padded);
+            for (int i = 0; i < n; i++) {
+                std::copy(A.row(i), A.row(i) + n, Ap.row(i));
+                std::copy(B.row(i), B.row(i) + n, Bp.row(i));
+            }
+            strassen(block(Ap), block(Bp), Cp.data(), Cp.ld(), padded, cutoff, 0);
+            for (int i = 0; i < n; i++) {
+                std::copy(Cp.row(i), Cp.row(i) + n, C + i * ldc);
+            }
+        }
+    }
+}
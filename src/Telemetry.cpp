@@ -0,0 +1,41 @@
+#include "Telemetry.h"
+#include <algorithm>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#endif
+
+double MultiplyTelemetry::imbalance() const {
+    if (threads.empty()) return 1.0;
+    double maxBusy = 0, sumBusy = 0;
+    for (const auto& t : threads) {
+        maxBusy = std::max(maxBusy, t.busy());
+        sumBusy += t.busy();
+    }
+    const double meanBusy = sumBusy / threads.size();
+    return meanBusy > 0 ? maxBusy / meanBusy : 1.0;
+}
+
+int currentCpu() {
+#ifdef _WIN32
+    return static_cast<int>(GetCurrentProcessorNumber());
+#elif defined(__linux__)
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+void printTelemetry(std::ostream& out, const MultiplyTelemetry& telemetry) {
+    long long total = 0;
+    for (const auto& t : telemetry.threads) total += t.iterations;
+    for (const auto& t : telemetry.threads) {
+        out << "[Поток " << t.thread << ": ядро " << t.cpu << ", узел " << t.node << ", запущен через " << t.start
+            << " сек, завершил работу за " << t.busy() << " секунд, итераций " << t.iterations << " ("
+            << (total > 0 ? 100.0 * t.iterations / total : 0.0) << "%)]\n";
+    }
+    out << "[Планировка " << telemetry.schedule << ": время " << telemetry.totalTime
+        << " сек, дисбаланс " << telemetry.imbalance() << "]\n";
+}
@@ -0,0 +1,157 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include "Affinity.h"
+#include "MatrixStorage.h"
+
+namespace {
+
+// Очередь плиток одного участника на отдельной кэш-линии
+struct alignas(MATRIX_ALIGNMENT) TileDeque {
+    std::mutex mutex;
+    std::deque<int> tiles;
+};
+
+} // namespace
+
+struct ThreadPool::Job {
+    const TileBody* body;
+    int rows, cols, tileRows, tileCols, tilesJ;
+    std::vector<TileDeque> deques;
+    std::atomic<int> remaining;
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+
+    Job(const TileBody* body, int rows, int cols, int tileRows, int tileCols, int tiles, int participants)
+        : body(body), rows(rows), cols(cols), tileRows(tileRows), tileCols(tileCols),
+          tilesJ((cols + tileCols - 1) / tileCols), deques(participants), remaining(tiles) {}
+
+    // Следующая плитка участника slot: с конца своей очереди, иначе с начала чужих; -1 - плиток нет
+    int take(int slot) {
+        {
+            std::lock_guard<std::mutex> lock(deques[slot].mutex);
+            if (!deques[slot].tiles.empty()) {
+                const int tile = deques[slot].tiles.back();
+                deques[slot].tiles.pop_back();
+                return tile;
+            }
+        }
+        const int count = static_cast<int>(deques.size());
+        for (int step = 1; step < count; step++) {
+            TileDeque& victim = deques[(slot + step) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tiles.empty()) {
+                const int tile = victim.tiles.front();
+                victim.tiles.pop_front();
+                return tile;
+            }
+        }
+        return -1;
+    }
+
+    void execute(int worker, int tile) {
+        const int i0 = tile / tilesJ * tileRows;
+        const int j0 = tile % tilesJ * tileCols;
+        try {
+            (*body)(worker, i0, std::min(i0 + tileRows, rows), j0, std::min(j0 + tileCols, cols));
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) error = std::current_exception();
+        }
+        if (remaining.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_all();
+        }
+    }
+};
+
+ThreadPool::ThreadPool(int count, bool pin) {
+    if (count <= 0) {
+        throw std::invalid_argument("ThreadPool: количество потоков должно быть положительным");
+    }
+    AffinityConfig affinity;
+    affinity.policy = pin ? AffinityPolicy::Compact : AffinityPolicy::None;
+    const std::vector<int> cpus = affinityPlan(affinity, count);
+    for (int i = 0; i < count; i++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < count; i++) {
+        workers[i]->thread = std::thread(&ThreadPool::run, this, i, cpus.empty() ? -1 : cpus[i]);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    for (auto& worker : workers) {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->stopping = true;
+        worker->wake.notify_one();
+    }
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+    return pool;
+}
+
+void ThreadPool::run(int index, int cpu) {
+    pinCurrentThread(cpu);
+    Worker& self = *workers[index];
+    while (true) {
+        Assignment assignment;
+        {
+            std::unique_lock<std::mutex> lock(self.mutex);
+            self.wake.wait(lock, [&] { return self.stopping || !self.assignments.empty(); });
+            if (self.assignments.empty()) return;
+            assignment = std::move(self.assignments.front());
+            self.assignments.pop_front();
+        }
+        for (int tile = assignment.job->take(assignment.slot); tile >= 0;
+            tile = assignment.job->take(assignment.slot)) {
+            assignment.job->execute(index, tile);
+        }
+    }
+}
+
+void ThreadPool::parallelFor2D(int rows, int cols, int tileRows, int tileCols, int maxWorkers,
+    const TileBody& body) {
+    if (tileRows <= 0 || tileCols <= 0 || maxWorkers <= 0) {
+        throw std::invalid_argument("ThreadPool::parallelFor2D: размеры плиток и число потоков должны быть положительными");
+    }
+    if (rows <= 0 || cols <= 0) return;
+    const int tiles = ((rows + tileRows - 1) / tileRows) * ((cols + tileCols - 1) / tileCols);
+    const int participants = std::min({ maxWorkers, size(), tiles });
+    auto job = std::make_shared<Job>(&body, rows, cols, tileRows, tileCols, tiles, participants);
+
+    // Непрерывные диапазоны плиток: соседние плитки одного участника делят строки A
+    for (int slot = 0; slot < participants; slot++) {
+        const int begin = static_cast<int>(static_cast<long long>(tiles) * slot / participants);
+        const int end = static_cast<int>(static_cast<long long>(tiles) * (slot + 1) / participants);
+        for (int tile = end - 1; tile >= begin; tile--) {
+            job->deques[slot].tiles.push_back(tile);
+        }
+    }
+
+    int start;
+    {
+        std::lock_guard<std::mutex> lock(startMutex);
+        start = nextStart;
+        nextStart = (nextStart + participants) % size();
+    }
+    for (int slot = 0; slot < participants; slot++) {
+        Worker& worker = *workers[(start + slot) % size()];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.assignments.push_back({ job, slot });
+        worker.wake.notify_one();
+    }
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->done.wait(lock, [&] { return job->remaining.load() == 0; });
+    if (job->error) std::rethrow_exception(job->error);
+}
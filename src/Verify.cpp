@@ -0,0 +1,106 @@
+#include "Verify.h"
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include "Random.h"
+
+namespace {
+
+/**
+* out = op(M) * X по модулю 2^32 для всех раундов сразу. Векторы раундов хранятся подряд:
+* элемент j раунда r - X[r * inner + j], результата - out[r * rows + i]. При MASKS элементы X -
+* маски 0 или ~0u (вектор из нулей и единиц), и умножение заменяется поразрядным И.
+*/
+template <bool MASKS>
+void multiplyRounds(Transpose op, MatrixView<int> M, const std::vector<std::uint32_t>& X, int rounds,
+    std::vector<std::uint32_t>& out, int num_threads) {
+    const int rows = op == Transpose::N ? M.rows() : M.cols();
+    const int inner = op == Transpose::N ? M.cols() : M.rows();
+    out.assign(static_cast<std::size_t>(rows) * rounds, 0);
+
+    if (op == Transpose::N) {
+        // Строка M остаётся в L1 на все раунды, скалярные произведения векторизуются
+        #pragma omp parallel for num_threads(num_threads) schedule(static)
+        for (int i = 0; i < rows; i++) {
+            const int* m = M.row(i);
+            for (int r = 0; r < rounds; r++) {
+                const std::uint32_t* x = &X[static_cast<std::size_t>(r) * inner];
+                std::uint32_t sum = 0;
+                if (MASKS) {
+                    #pragma omp simd reduction(+ : sum)
+                    for (int j = 0; j < inner; j++) sum += static_cast<std::uint32_t>(m[j]) & x[j];
+                }
+                else {
+                    #pragma omp simd reduction(+ : sum)
+                    for (int j = 0; j < inner; j++) sum += static_cast<std::uint32_t>(m[j]) * x[j];
+                }
+                out[static_cast<std::size_t>(r) * rows + i] = sum;
+            }
+        }
+        return;
+    }
+
+    // op(M)(i, j) = M(j, i): хранимые строки читаются подряд, потоки делят их на диапазоны столбцов
+    #pragma omp parallel num_threads(num_threads)
+    {
+        const int threads = omp_get_num_threads();
+        const int t = omp_get_thread_num();
+        const int i0 = static_cast<int>(static_cast<long long>(rows) * t / threads);
+        const int i1 = static_cast<int>(static_cast<long long>(rows) * (t + 1) / threads);
+        for (int j = 0; j < inner; j++) {
+            const int* m = M.row(j);
+            for (int r = 0; r < rounds; r++) {
+                const std::uint32_t value = X[static_cast<std::size_t>(r) * inner + j];
+                if (value == 0) continue;
+                std::uint32_t* acc = &out[static_cast<std::size_t>(r) * rows];
+                if (MASKS) {
+                    #pragma omp simd
+                    for (int i = i0; i < i1; i++) acc[i] += static_cast<std::uint32_t>(m[i]);
+                }
+                else {
+                    #pragma omp simd
+                    for (int i = i0; i < i1; i++) acc[i] += value * static_cast<std::uint32_t>(m[i]);
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+bool freivaldsCheck(Transpose opA, Transpose opB, int alpha, MatrixView<int> A, MatrixView<int> B,
+    MatrixView<int> C, int rounds, std::uint64_t seed, int num_threads) {
+    if (rounds < 1 || rounds > FREIVALDS_MAX_ROUNDS) {
+        throw std::invalid_argument("freivaldsCheck: число раундов должно быть от 1 до "
+            + std::to_string(FREIVALDS_MAX_ROUNDS));
+    }
+    const int m = opA == Transpose::N ? A.rows() : A.cols();
+    const int k = opA == Transpose::N ? A.cols() : A.rows();
+    const int kB = opB == Transpose::N ? B.rows() : B.cols();
+    const int n = opB == Transpose::N ? B.cols() : B.rows();
+    if (k != kB || C.rows() != m || C.cols() != n) {
+        throw std::invalid_argument("freivaldsCheck: размеры матриц не согласованы");
+    }
+
+    // Бит r значения с номером j - элемент j вектора раунда r, хранится маской 0 или ~0u
+    std::vector<std::uint32_t> x(static_cast<std::size_t>(n) * rounds);
+    #pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (int j = 0; j < n; j++) {
+        const std::uint64_t bits = counterRandom(seed, static_cast<std::uint64_t>(j));
+        for (int r = 0; r < rounds; r++) {
+            x[static_cast<std::size_t>(r) * n + j] = 0u - (static_cast<std::uint32_t>(bits >> r) & 1u);
+        }
+    }
+
+    std::vector<std::uint32_t> bx, abx, cx;
+    multiplyRounds<true>(opB, B, x, rounds, bx, num_threads);
+    multiplyRounds<false>(opA, A, bx, rounds, abx, num_threads);
+    multiplyRounds<true>(Transpose::N, C, x, rounds, cx, num_threads);
+
+    const std::uint32_t scale = static_cast<std::uint32_t>(alpha);
+    for (std::size_t i = 0; i < cx.size(); i++) {
+        if (cx[i] != scale * abx[i]) return false;
+    }
+    return true;
+}
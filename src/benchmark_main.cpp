@@ -0,0 +1,48 @@
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include "Benchmark.h"
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace {
+
+void writeFile(const std::string& path, void (*writer)(std::ostream&, const std::vector<BenchmarkResult>&),
+    const std::vector<BenchmarkResult>& results) {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("Не удалось открыть файл " + path);
+    }
+    writer(file, results);
+}
+
+} // namespace
+
+/**
+* @brief Перебор размеров, потоков, планировок и вариантов умножения из командной строки.
+* Пример: matrix_benchmark --sizes 512,1024 --threads 1,4 --kernels linear,blocked --reps 7 --csv out.csv
+*/
+int main(int argc, char** argv) {
+    #ifdef _WIN32
+    SetConsoleOutputCP(65001);
+    SetConsoleCP(65001);
+    #endif
+
+    try {
+        const BenchmarkConfig config = parseBenchmarkArgs(argc, argv);
+        const std::vector<BenchmarkResult> results = runBenchmark(config, &std::cerr);
+
+        printTable(std::cout, results);
+        if (!config.csvPath.empty()) writeFile(config.csvPath, writeCsv, results);
+        if (!config.jsonPath.empty()) writeFile(config.jsonPath, writeJson, results);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << std::endl;
+        std::cerr << "Использование: " << argv[0] << " [--sizes 500,1000] [--threads 1,2,4] "
+            << "[--schedules static,dynamic,guided,steal] [--kernels linear,parallel,blocked,pool,strassen,int8,int16,auto,sparse,spmm] "
+            << "[--densities 1,0.1,0.01] [--affinity none|compact|spread|0,2,4] [--numa on|off] [--perf on|off] [--warmup 1] [--reps 5] [--csv file] [--json file]" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -4,7 +4,22 @@
  */
 #include "MatrixTest.h"
 #include "Matrix.h"
+#include "MicroKernels.h"
+#include "Benchmark.h"
+#include "AutoTuner.h"
+#include "Random.h"
+#include "Batched.h"
+#include "FixedMatrix.h"
+#include "Sparse.h"
+#include "MappedMatrix.h"
+#include "ThreadPool.h"
+#include "Affinity.h"
+#include "AsyncMultiply.h"
+#include "Chain.h"
+#include "ResultCache.h"
+#include "Expression.h"
 #include <cassert>
+#include <climits>
 #include <cmath>
 #include <vector>
 #include <iostream>
@@ -14,6 +29,14 @@
 #include <thread>
 #include <vector>
 #include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <sstream>
+#include <cstdio>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
 
 const double MatrixTest::PERFORMANCE_TOLERANCE = 0.8;
 
@@ -47,6 +70,31 @@ void MatrixTest::runAllTests() {
     runTest("Безопасность потоков", testThreadSafety);
     runTest("Параллельная инициализация", testConcurrentInitialization);
     runTest("Проверка состояний гонки", testRaceCondition);
+    runTest("Непрерывное хранилище", testContiguousStorage);
+    runTest("Блочное умножение", testBlockedMultiply);
+    runTest("Неверная планировка", testInvalidSchedule);
+    runTest("SIMD-микроядра", testMicroKernels);
+    runTest("Штрассен-Виноград", testStrassen);
+    runTest("Узкие типы элементов", testNarrowTypes);
+    runTest("Бенчмарк", testBenchmarkHarness);
+    runTest("Телеметрия потоков", testTelemetry);
+    runTest("Автонастройка", testAutoTuner);
+    runTest("Воспроизводимая инициализация", testSeededInitialization);
+    runTest("Сеттеры без копирования", testZeroCopySetters);
+    runTest("GEMM", testGemm);
+    runTest("Пакетное умножение", testBatched);
+    runTest("Матрицы фиксированного размера", testFixedMatrix);
+    runTest("Разреженные операнды", testSparse);
+    runTest("Умножение матриц из файлов", testOutOfCore);
+    runTest("Пул потоков", testThreadPool);
+    runTest("Асинхронные умножения", testAsyncMultiply);
+    runTest("Цепочки и степени", testChain);
+    runTest("Частичный пересчёт", testIncremental);
+    runTest("Кэш результатов", testResultCache);
+    runTest("Выражения с эпилогами", testExpressions);
+    runTest("Проверка Фрейвалдса", testVerify);
+    runTest("Аппаратные счётчики", testPerfCounters);
+    runTest("Закрепление потоков", testAffinity);
 
     std::cout << "\n*** Результаты тестов ***" << std::endl;
     std::cout << "Пройдено: " << passedTests << "/" << totalTests << " тестов" << std::endl;
@@ -191,6 +239,14 @@ void MatrixTest::testKnownMatrices() {
     std::vector<std::vector<int>> expected = { {4, 4}, {10, 8} };
     matrix.multiplyParallel(2, "static");
     assert(areMatricesEqual(matrix.getMatrixC(), expected));
+
+    // 4x4 через multiplyLinear - ядро фиксированного размера
+    Matrix fixed(4);
+    fixed.setMatrixA({ {1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}, {13, 14, 15, 16} });
+    fixed.setMatrixB({ {1, 0, 0, 1}, {0, 1, 1, 0}, {2, 0, 0, -1}, {0, -1, 3, 0} });
+    expected = { {7, -2, 14, -2}, {19, -2, 30, -2}, {31, -2, 46, -2}, {43, -2, 62, -2} };
+    fixed.multiplyLinear();
+    assert(areMatricesEqual(fixed.getMatrixC(), expected));
 }
 
 /**
@@ -225,6 +281,20 @@ void MatrixTest::testThreadSafety() {
         }
         assert(hasNonZero);
     }
+
+    // Одновременные константные обращения к ещё не выделенным матрицам: заполнение одно на всех
+    const Matrix fresh(matrixSize);
+    std::vector<const int*> views(numConcurrentOperations);
+    std::vector<const std::vector<std::vector<int>>*> copies(numConcurrentOperations);
+#pragma omp parallel for schedule(static) num_threads(4)
+    for (int i = 0; i < numConcurrentOperations; i++) {
+        views[i] = fresh.viewC().data();
+        copies[i] = &fresh.getMatrixC();
+    }
+    for (int i = 0; i < numConcurrentOperations; i++) {
+        assert(views[i] == views[0] && copies[i] == copies[0]);
+        assert(copies[i]->size() == matrixSize && (*copies[i])[0][0] == 0);
+    }
 }
 
 /**
@@ -272,6 +342,1345 @@ void MatrixTest::testRaceCondition() {
     std::cout << "Состояния гонки не обнаружены после " << numIterations << " итераций" << std::endl;
 }
 
+/**
+ * @brief Тестирование непрерывного хранилища
+ *
+ * Проверка выравнивания буфера и строк, дополнения шага строки и согласованности
+ * представления MatrixView с геттером в виде вектора векторов
+ */
+void MatrixTest::testContiguousStorage() {
+    std::cout << "Проверка непрерывного хранилища" << std::endl;
+    const int size = 37;
+    Matrix matrix(size);
+    matrix.initialize();
+
+    MatrixView<int> view = matrix.viewA();
+    assert(view.rows() == size && view.cols() == size);
+    assert(view.ld() >= size);
+    assert(reinterpret_cast<std::uintptr_t>(view.data()) % MATRIX_ALIGNMENT == 0);
+    assert((view.ld() * sizeof(int)) % MATRIX_ALIGNMENT == 0);
+
+    const auto& nestedA = matrix.getMatrixA();
+    for (int i = 0; i < size; i++) {
+        for (int j = 0; j < size; j++) {
+            assert(view(i, j) == nestedA[i][j]);
+        }
+    }
+
+    MatrixView<int> sub = view.block(3, 5, 4, 6);
+    assert(sub(0, 0) == nestedA[3][5] && sub(3, 5) == nestedA[6][10]);
+
+    // Шаг строки в 4 КБ дополняется, чтобы строки не конкурировали за один набор кэша
+    assert(AlignedMatrix<int>::paddedLeadingDimension(1024) != 1024);
+
+    matrix.multiplyLinear();
+    auto expected = simpleMultiply(matrix.getMatrixA(), matrix.getMatrixB());
+    assert(areMatricesEqual(matrix.getMatrixC(), expected));
+
+    assert(expectThrows<std::invalid_argument>([&] { matrix.setMatrixA({ {1, 2}, {3, 4} }); }));
+
+    // Строка неверной длины в конце: ни одна строка не записывается
+    const auto before = matrix.getMatrixA();
+    std::vector<std::vector<int>> ragged(size, std::vector<int>(size, 7));
+    ragged.back().pop_back();
+    assert(expectThrows<std::invalid_argument>([&] { matrix.setMatrixA(ragged); }));
+    MatrixView<int> stored = matrix.viewA();
+    for (int i = 0; i < size; i++) {
+        for (int j = 0; j < size; j++) assert(stored(i, j) == before[i][j]);
+    }
+}
+
+/**
+ * @brief Тестирование блочного умножения
+ *
+ * Проверка, что последовательный и параллельный блочные варианты совпадают с линейным
+ * при размерах, не кратных размерам блоков
+ */
+void MatrixTest::testBlockedMultiply() {
+    std::cout << "Проверка блочного умножения" << std::endl;
+    Matrix matrix(67);
+    matrix.initialize();
+    matrix.multiplyLinear();
+    auto linearResult = matrix.getMatrixC();
+
+    struct Tiles { int i, j, k; };
+    std::vector<Tiles> tileSets = { {64, 256, 128}, {8, 16, 5}, {1, 1, 1}, {100, 100, 100} };
+    for (const auto& t : tileSets) {
+        matrix.multiplyBlocked(t.i, t.j, t.k);
+        assert(areMatricesEqual(matrix.getMatrixC(), linearResult));
+        matrix.multiplyBlockedParallel(3, t.i, t.j, t.k);
+        assert(areMatricesEqual(matrix.getMatrixC(), linearResult));
+    }
+
+    assert(expectThrows<std::invalid_argument>([&] { matrix.multiplyBlocked(0, 16, 16); }));
+}
+
+/**
+ * @brief Тестирование обработки неверных аргументов
+ *
+ * Проверка, что неизвестный тип планирования и неположительное количество потоков
+ * отклоняются, а не приводят к молчаливому пропуску умножения
+ */
+void MatrixTest::testInvalidSchedule() {
+    std::cout << "Проверка неверной планировки" << std::endl;
+    Matrix matrix(8);
+    matrix.initialize();
+
+    assert(expectThrows<std::invalid_argument>([&] { matrix.multiplyParallel(2, "auto-magic"); }));
+
+    assert(expectThrows<std::invalid_argument>([&] { matrix.multiplyParallel(0, "static"); }));
+}
+
+/**
+ * @brief Тестирование SIMD-микроядер
+ *
+ * Каждое доступное микроядро (AVX-512, AVX2, скалярное) подставляется в блочное умножение
+ * и сравнивается с линейным на размерах, дающих неполные краевые блоки
+ */
+void MatrixTest::testMicroKernels() {
+    std::cout << "Проверка SIMD-микроядер" << std::endl;
+    const std::string defaultKernel = activeMicroKernel().name;
+    Matrix matrix(75);
+    matrix.initialize();
+    matrix.multiplyLinear();
+    auto linearResult = matrix.getMatrixC();
+
+    for (const MicroKernel* kernel : availableMicroKernels()) {
+        std::cout << "Микроядро " << kernel->name << " (" << kernel->mr << "x" << kernel->nr << ")" << std::endl;
+        assert(setActiveMicroKernel(kernel->name));
+        matrix.multiplyBlocked(40, 48, 33);
+        assert(areMatricesEqual(matrix.getMatrixC(), linearResult));
+        matrix.multiplyBlockedParallel(3);
+        assert(areMatricesEqual(matrix.getMatrixC(), linearResult));
+    }
+
+    assert(!setActiveMicroKernel("no-such-kernel"));
+    assert(setActiveMicroKernel(defaultKernel));
+}
+
+/**
+ * @brief Тестирование умножения по Штрассену-Винограду
+ *
+ * Проверка побитового совпадения с линейным умножением при нескольких уровнях рекурсии,
+ * в том числе для размеров, требующих дополнения нулями
+ */
+void MatrixTest::testStrassen() {
+    std::cout << "Проверка умножения Штрассена-Винограда" << std::endl;
+    struct Case { int size, cutoff; };
+    std::vector<Case> cases = { {1, 8}, {37, 8}, {64, 16}, {130, 16}, {100, 512} };
+    for (const auto& c : cases) {
+        Matrix matrix(c.size);
+        matrix.initialize();
+        matrix.multiplyLinear();
+        auto linearResult = matrix.getMatrixC();
+        matrix.multiplyStrassen(4, c.cutoff);
+        assert(areMatricesEqual(matrix.getMatrixC(), linearResult));
+    }
+
+    assert(expectThrows<std::invalid_argument>([&] {
+        Matrix matrix(4);
+        matrix.multiplyStrassen(2, 0);
+    }));
+}
+
+/**
+ * @brief Тестирование узких типов элементов
+ *
+ * Проверка, что хранение в int8/int16 с накоплением в int32 и int64 даёт тот же результат,
+ * что и линейное умножение, а выход за диапазон типа или int обнаруживается
+ */
+void MatrixTest::testNarrowTypes() {
+    std::cout << "Проверка узких типов элементов" << std::endl;
+    Matrix matrix(53);
+    matrix.initialize();
+    matrix.multiplyLinear();
+    auto linearResult = matrix.getMatrixC();
+
+    std::vector<ElementType> types = { ElementType::Int8, ElementType::Int16, ElementType::Int32 };
+    for (ElementType type : types) {
+        matrix.multiplyNarrow(3, type);
+        assert(areMatricesEqual(matrix.getMatrixC(), linearResult));
+        matrix.multiplyNarrow(3, type, Accumulation::Int64Checked);
+        assert(areMatricesEqual(matrix.getMatrixC(), linearResult));
+    }
+
+    AlignedMatrix<std::int16_t> A16 = narrowCopy<std::int16_t>(matrix.viewA());
+    AlignedMatrix<std::int16_t> B16 = narrowCopy<std::int16_t>(matrix.viewB());
+    AlignedMatrix<std::int64_t> wide(53, 53);
+    multiplyNarrowKernel(A16.view(), B16.view(), wide.data(), wide.ld(), 2);
+    for (int i = 0; i < 53; i++) {
+        for (int j = 0; j < 53; j++) {
+            assert(wide(i, j) == linearResult[i][j]);
+        }
+    }
+
+    Matrix large(2);
+    large.setMatrixA({ {100000, 100000}, {1, 1} });
+    large.setMatrixB({ {100000, 1}, {100000, 1} });
+    assert(expectThrows<std::overflow_error>([&] {
+        large.multiplyNarrow(2, ElementType::Int32, Accumulation::Int64Checked);
+    }));
+
+    assert(expectThrows<std::out_of_range>([&] { large.multiplyNarrow(2, ElementType::Int16); }));
+}
+
+/**
+ * @brief Тестирование бенчмарка
+ *
+ * Проверка статистики по замерам, разбора аргументов командной строки и состава
+ * результатов небольшого перебора
+ */
+void MatrixTest::testBenchmarkHarness() {
+    std::cout << "Проверка бенчмарка" << std::endl;
+    SampleStats stats = computeStats({ 5, 1, 4, 2, 3 });
+    assert(stats.min == 1 && stats.median == 3 && stats.p95 == 5 && stats.mean == 3);
+    stats = computeStats({ 4, 1, 2, 3 });
+    assert(stats.median == 2.5);
+
+    const char* args[] = { "bench", "--sizes", "16,24", "--threads", "1,2", "--kernels", "linear,parallel,blocked",
+        "--schedules", "static", "--warmup", "0", "--reps", "2" };
+    BenchmarkConfig config = parseBenchmarkArgs(13, const_cast<char**>(args));
+    assert(config.sizes == std::vector<int>({ 16, 24 }));
+    assert(config.repetitions == 2 && config.warmup == 0);
+
+    std::vector<BenchmarkResult> results = runBenchmark(config, nullptr);
+    // На каждый размер: linear x1, parallel static x2 потока, blocked x2 потока
+    assert(results.size() == 10);
+    for (const auto& r : results) {
+        assert(r.samples.size() == 2);
+        assert(r.stats.min <= r.stats.median && r.stats.median <= r.stats.p95);
+        assert(r.speedupLinear > 0);
+        if (r.threads == 1) assert(r.speedupSingle == 1);
+    }
+
+    std::ostringstream csv;
+    writeCsv(csv, results);
+    assert(csv.str().rfind("size,kernel,schedule,threads", 0) == 0);
+
+    const char* sparseArgs[] = { "bench", "--sizes", "40", "--threads", "2", "--kernels", "linear,sparse",
+        "--densities", "1,0.05", "--warmup", "0", "--reps", "1" };
+    results = runBenchmark(parseBenchmarkArgs(13, const_cast<char**>(sparseArgs)), nullptr);
+    assert(results.size() == 4 && results[0].density == 1.0 && results[3].density == 0.05);
+    assert(results[3].kernel == "sparse" && results[3].speedupLinear > 0);
+
+    const char* badArgs[][3] = { { "bench", "--kernels", "quantum" }, { "bench", "--reps", "3,5" },
+        { "bench", "--reps", "0" }, { "bench", "--warmup", "2x" }, { "bench", "--warmup", "-1" } };
+    for (const auto& bad : badArgs) {
+        assert(expectThrows<std::invalid_argument>([&] { parseBenchmarkArgs(3, const_cast<char**>(bad)); }));
+    }
+}
+
+/**
+ * @brief Тестирование телеметрии
+ *
+ * Проверка, что после параллельного умножения записи потоков покрывают все итерации
+ * и содержат согласованные времена
+ */
+void MatrixTest::testTelemetry() {
+    std::cout << "Проверка телеметрии потоков" << std::endl;
+    const int size = 30;
+    Matrix matrix(size);
+    matrix.initialize();
+
+    std::vector<std::string> schedules = { "static", "dynamic", "guided" };
+    for (const auto& schedule : schedules) {
+        double time = matrix.multiplyParallel(3, schedule);
+        const MultiplyTelemetry& telemetry = matrix.lastTelemetry();
+        assert(telemetry.schedule == schedule);
+        assert(telemetry.totalTime == time);
+        assert(!telemetry.threads.empty() && telemetry.threads.size() <= 3);
+
+        long long iterations = 0;
+        for (size_t t = 0; t < telemetry.threads.size(); t++) {
+            const ThreadTelemetry& record = telemetry.threads[t];
+            assert(record.thread == static_cast<int>(t));
+            assert(record.start >= 0 && record.end >= record.start);
+            iterations += record.iterations;
+        }
+        assert(iterations == static_cast<long long>(size) * size);
+        assert(telemetry.imbalance() >= 1.0);
+    }
+    printTelemetry(std::cout, matrix.lastTelemetry());
+}
+
+/**
+ * @brief Тестирование автотюнера
+ *
+ * Проверка, что настройка выполняется один раз на корзину размеров, multiplyAuto даёт
+ * верный результат, а новый автотюнер берёт конфигурацию из файла кэша без повторной настройки
+ */
+void MatrixTest::testAutoTuner() {
+    std::cout << "Проверка автонастройки" << std::endl;
+    const std::string path = "matrix_tuning_test.cache";
+    std::remove(path.c_str());
+
+    AutoTuner tuner(path);
+    const TuningConfig first = tuner.configFor(100);
+    assert(tuner.tuningRuns() == 1);
+    assert(first.threads >= 1 && first.time > 0);
+    tuner.configFor(120);
+    assert(tuner.tuningRuns() == 1);
+    assert(AutoTuner::bucketOf(100) == 6 && AutoTuner::bucketOf(128) == 7);
+
+    Matrix matrix(100);
+    matrix.initialize();
+    matrix.multiplyAuto(tuner);
+    auto autoResult = matrix.getMatrixC();
+    matrix.multiplyLinear();
+    assert(areMatricesEqual(autoResult, matrix.getMatrixC()));
+
+    AutoTuner reloaded(path);
+    const TuningConfig cached = reloaded.configFor(110);
+    assert(reloaded.tuningRuns() == 0);
+    assert(cached.threads == first.threads && cached.schedule == first.schedule && cached.chunk == first.chunk);
+    assert(cached.tiles.tile_i == first.tiles.tile_i && cached.tiles.tile_k == first.tiles.tile_k);
+
+    std::remove(path.c_str());
+}
+
+/**
+ * @brief Тестирование инициализации с заданным seed
+ *
+ * Проверка, что один seed даёт одинаковые матрицы при разном числе потоков, элементы
+ * совпадают с последовательным вычислением генератора и лежат в [-100, 100]
+ */
+void MatrixTest::testSeededInitialization() {
+    std::cout << "Проверка воспроизводимой инициализации" << std::endl;
+    const int size = 300;
+    const int savedThreads = omp_get_max_threads();
+
+    omp_set_num_threads(1);
+    Matrix single(size);
+    single.initialize(42);
+    omp_set_num_threads(4);
+    Matrix parallel(size);
+    parallel.initialize(42);
+    omp_set_num_threads(savedThreads);
+
+    assert(areMatricesEqual(single.getMatrixA(), parallel.getMatrixA()));
+    assert(areMatricesEqual(single.getMatrixB(), parallel.getMatrixB()));
+    assert(!areMatricesEqual(single.getMatrixA(), single.getMatrixB()));
+
+    const std::uint64_t keyA = counterRandom(42, 0);
+    const auto& A = single.getMatrixA();
+    int minValue = 0, maxValue = 0;
+    for (int i = 0; i < size; i++) {
+        for (int j = 0; j < size; j++) {
+            assert(A[i][j] == counterUniform(keyA, static_cast<std::uint64_t>(i) * size + j, -100, 100));
+            minValue = std::min(minValue, A[i][j]);
+            maxValue = std::max(maxValue, A[i][j]);
+        }
+    }
+    assert(minValue == -100 && maxValue == 100);
+
+    parallel.initialize(43);
+    assert(!areMatricesEqual(single.getMatrixA(), parallel.getMatrixA()));
+}
+
+/**
+ * @brief Тестирование сеттеров без копирования
+ *
+ * Проверка ленивого выделения (невыделенные матрицы нулевые), переноса вектора векторов
+ * и AlignedMatrix, а также работы с внешними буферами A, B и C с произвольным шагом строки
+ */
+void MatrixTest::testZeroCopySetters() {
+    std::cout << "Проверка сеттеров без копирования" << std::endl;
+    const int size = 3;
+    const std::ptrdiff_t ld = 5;
+    Matrix matrix(size);
+    assert(areMatricesEqual(matrix.getMatrixC(), std::vector<std::vector<int>>(size, std::vector<int>(size, 0))));
+
+    std::vector<int> bufferA(size * ld, -1), bufferB(size * ld, -1), bufferC(size * ld, -1);
+    for (int i = 0; i < size; i++) {
+        for (int j = 0; j < size; j++) {
+            bufferA[i * ld + j] = i + 2 * j;
+            bufferB[i * ld + j] = 3 * i - j;
+        }
+    }
+    matrix.adoptMatrixA(bufferA.data(), size, size, ld);
+    matrix.adoptMatrixB(bufferB.data(), size, size, ld);
+    matrix.adoptMatrixC(bufferC.data(), size, size, ld);
+    assert(matrix.viewA().data() == bufferA.data() && matrix.viewB().ld() == ld);
+
+    std::vector<std::vector<int>> nestedA = matrix.getMatrixA();
+    std::vector<std::vector<int>> nestedB = matrix.getMatrixB();
+    auto expected = simpleMultiply(nestedA, nestedB);
+    matrix.multiplyBlockedParallel(2);
+    assert(areMatricesEqual(matrix.getMatrixC(), expected));
+    for (int i = 0; i < size; i++) {
+        for (int j = 0; j < size; j++) {
+            assert(bufferC[i * ld + j] == expected[i][j]);
+        }
+        assert(bufferC[i * ld + size] == -1);
+    }
+
+    // Изменение внешнего буфера между умножениями: узкие копии строятся заново
+    std::vector<int> ones(4 * 4, 1), onesB(4 * 4, 1);
+    Matrix adopted(4);
+    adopted.adoptMatrixA(ones.data(), 4, 4, 4);
+    adopted.adoptMatrixB(onesB.data(), 4, 4, 4);
+    adopted.multiplyNarrow(1, ElementType::Int8);
+    assert(adopted.getMatrixC()[0][0] == 4);
+    ones[0] = 5;
+    adopted.multiplyNarrow(1, ElementType::Int8);
+    assert(adopted.getMatrixC()[0][0] == 8 && adopted.getMatrixA()[0][0] == 5);
+
+    // Отклонённое значение не отменяет привязку к внешнему буферу
+    std::vector<std::vector<int>> ragged(size, std::vector<int>(size, 0));
+    ragged[1].push_back(0);
+    for (bool move : { false, true }) {
+        assert(expectThrows<std::invalid_argument>([&] {
+            if (move) matrix.setMatrixB(std::vector<std::vector<int>>(ragged));
+            else matrix.setMatrixB(ragged);
+        }) && matrix.viewB().data() == bufferB.data());
+    }
+
+    // Новое значение A не записывается во внешний буфер
+    const std::vector<int> savedA = bufferA;
+    matrix.setMatrixA(std::vector<std::vector<int>>(size, std::vector<int>(size, 1)));
+    assert(bufferA == savedA && matrix.viewA().data() != bufferA.data());
+
+    Matrix moved(size);
+    std::vector<std::vector<int>> source = nestedA;
+    moved.setMatrixA(std::move(source));
+    assert(source.empty());
+    assert(areMatricesEqual(moved.getMatrixA(), nestedA));
+
+    AlignedMatrix<int> storage(size, size);
+    storage.assign(nestedB);
+    const int* storageData = storage.data();
+    moved.setMatrixB(std::move(storage));
+    assert(moved.viewB().data() == storageData);
+    moved.multiplyLinear();
+    assert(areMatricesEqual(moved.getMatrixC(), expected));
+
+    std::vector<std::vector<int>> wrong(size + 1, std::vector<int>(size, 0));
+    assert(expectThrows<std::invalid_argument>([&] {
+        moved.setMatrixA(std::move(wrong));
+    }) && wrong.size() == static_cast<size_t>(size + 1));
+}
+
+/**
+ * @brief Тестирование GEMM
+ *
+ * Проверка C = alpha * op(A) * op(B) + beta * C для всех сочетаний op при размерах, не кратных
+ * блокам, в том числе с маленькими блоками и разными планировками, и умножения прямоугольных матриц
+ */
+void MatrixTest::testGemm() {
+    std::cout << "Проверка GEMM" << std::endl;
+    const int m = 37, n = 29, k = 45;
+    const int alpha = 3, beta = -2;
+    const Transpose ops[] = { Transpose::N, Transpose::T };
+
+    for (Transpose opA : ops) {
+        for (Transpose opB : ops) {
+            Matrix matrix(m, n, k, opA, opB);
+            matrix.initialize(7);
+            std::vector<std::vector<int>> initialC(m, std::vector<int>(n));
+            for (int i = 0; i < m; i++) {
+                for (int j = 0; j < n; j++) initialC[i][j] = i - j;
+            }
+            matrix.setMatrixC(initialC);
+
+            const auto& A = matrix.getMatrixA();
+            const auto& B = matrix.getMatrixB();
+            assert(static_cast<int>(A.size()) == (opA == Transpose::N ? m : k));
+            std::vector<std::vector<int>> expected(m, std::vector<int>(n));
+            for (int i = 0; i < m; i++) {
+                for (int j = 0; j < n; j++) {
+                    int sum = 0;
+                    for (int p = 0; p < k; p++) {
+                        const int a = opA == Transpose::N ? A[i][p] : A[p][i];
+                        const int b = opB == Transpose::N ? B[p][j] : B[j][p];
+                        sum += a * b;
+                    }
+                    expected[i][j] = alpha * sum + beta * initialC[i][j];
+                }
+            }
+
+            matrix.gemm(alpha, beta, 2, "dynamic", 1);
+            assert(areMatricesEqual(matrix.getMatrixC(), expected));
+
+            // Маленькие блоки: несколько проходов по k и неполные полосы микроядра
+            AlignedMatrix<int> C(m, n);
+            C.assign(initialC);
+            gemmKernel(opA, opB, alpha, matrix.viewA(), matrix.viewB(), beta, C.data(), C.ld(),
+                BlockSizes{ 8, 16, 8 }, 3, "guided");
+            assert(areMatricesEqual(C.toNested(), expected));
+
+            if (opA != Transpose::N || opB != Transpose::N) {
+                assert(expectThrows<std::invalid_argument>([&] { matrix.multiplyLinear(); }));
+            }
+        }
+    }
+
+    Matrix rectangular(m, n, k);
+    rectangular.initialize(11);
+    rectangular.multiplyLinear();
+    auto linear = rectangular.getMatrixC();
+    assert(static_cast<int>(linear.size()) == m && static_cast<int>(linear[0].size()) == n);
+    rectangular.multiplyParallel(2, "static");
+    assert(areMatricesEqual(rectangular.getMatrixC(), linear));
+    rectangular.multiplyBlockedParallel(2, 8, 16, 8);
+    assert(areMatricesEqual(rectangular.getMatrixC(), linear));
+    rectangular.gemm(1, 0, 2);
+    assert(areMatricesEqual(rectangular.getMatrixC(), linear));
+}
+
+/**
+ * @brief Тестирование пакетного умножения
+ *
+ * Проверка пакета из произведений разных размеров (ядра фиксированного размера, общее
+ * и блочное) и пакета с постоянным шагом при всех типах планирования
+ */
+void MatrixTest::testBatched() {
+    std::cout << "Проверка пакетного умножения" << std::endl;
+    const std::vector<int> sizes = { 4, 8, 16, 32, 64, 5, 17, 130 };
+    std::vector<Matrix> products;
+    for (size_t e = 0; e < sizes.size(); e++) {
+        products.emplace_back(sizes[e]);
+        products.back().initialize(e);
+    }
+    std::vector<AlignedMatrix<int>> results;
+    std::vector<BatchEntry> batch;
+    for (auto& product : products) {
+        results.emplace_back(product.size(), product.size());
+        batch.push_back({ product.viewA(), product.viewB(), results.back().data(), results.back().ld() });
+    }
+    multiplyBatched(batch, 3, "dynamic");
+    for (size_t e = 0; e < products.size(); e++) {
+        products[e].multiplyLinear();
+        assert(areMatricesEqual(results[e].toNested(), products[e].getMatrixC()));
+    }
+
+    // Один поток: буферы упаковки переиспользуются произведениями разных размеров подряд
+    for (auto& result : results) {
+        for (int i = 0; i < result.rows(); i++) std::fill(result.row(i), result.row(i) + result.cols(), 0);
+    }
+    multiplyBatched(batch, 1);
+    for (size_t e = 0; e < products.size(); e++) {
+        assert(areMatricesEqual(results[e].toNested(), products[e].getMatrixC()));
+    }
+
+    const int count = 50, size = 16;
+    const std::ptrdiff_t stride = size * size;
+    std::vector<int> A(count * stride), B(count * stride), C(count * stride, -1);
+    for (size_t i = 0; i < A.size(); i++) {
+        A[i] = static_cast<int>(i % 13) - 6;
+        B[i] = static_cast<int>(i % 7) - 3;
+    }
+    StridedBatch strided;
+    strided.count = count;
+    strided.m = strided.n = strided.k = size;
+    strided.A = A.data();
+    strided.B = B.data();
+    strided.C = C.data();
+    strided.lda = strided.ldb = strided.ldc = size;
+    strided.strideA = strided.strideB = strided.strideC = stride;
+
+    std::vector<std::string> schedules = { "static", "dynamic", "guided" };
+    for (const auto& schedule : schedules) {
+        std::fill(C.begin(), C.end(), -1);
+        multiplyStridedBatched(strided, 4, schedule, 2);
+        for (int e = 0; e < count; e++) {
+            Matrix single(size);
+            single.adoptMatrixA(A.data() + e * stride, size, size, size);
+            single.adoptMatrixB(B.data() + e * stride, size, size, size);
+            single.multiplyLinear();
+            const auto& expected = single.getMatrixC();
+            for (int i = 0; i < size; i++) {
+                for (int j = 0; j < size; j++) {
+                    assert(C[e * stride + i * size + j] == expected[i][j]);
+                }
+            }
+        }
+    }
+
+    std::vector<BatchEntry> wrong = { { products[0].viewA(), products[1].viewB(), results[0].data(), results[0].ld() } };
+    assert(expectThrows<std::invalid_argument>([&] { multiplyBatched(wrong, 2); }));
+}
+
+/**
+ * @brief Тестирование матриц фиксированного размера
+ *
+ * Проверка multiply<N> и multiplyFixed с шагом строки, отличным от N, против общего
+ * умножения для всех поддерживаемых размеров
+ */
+void MatrixTest::testFixedMatrix() {
+    std::cout << "Проверка матриц фиксированного размера" << std::endl;
+    FixedMatrix<4> identity;
+    for (int i = 0; i < 4; i++) identity(i, i) = 1;
+    FixedMatrix<4> values = FixedMatrix<4>::fromNested({ {1, -2, 3, 4}, {5, 6, -7, 8}, {9, 10, 11, 12}, {0, 0, 1, 1} });
+    assert(multiply(values, identity) == values && multiply(identity, values) == values);
+
+    Matrix general(32);
+    general.initialize(3);
+    FixedMatrix<32> A = FixedMatrix<32>::fromNested(general.getMatrixA());
+    FixedMatrix<32> B = FixedMatrix<32>::fromNested(general.getMatrixB());
+    assert(areMatricesEqual(multiply(A, B).toNested(), simpleMultiply(general.getMatrixA(), general.getMatrixB())));
+
+    const std::vector<int> sizes = { 4, 8, 16, 32 };
+    for (int size : sizes) {
+        Matrix matrix(size);
+        matrix.initialize(size);
+        AlignedMatrix<int> C(size, size);
+        assert(multiplyFixedDispatch(size, matrix.viewA().data(), matrix.viewA().ld(), matrix.viewB().data(),
+            matrix.viewB().ld(), C.data(), C.ld()));
+        assert(areMatricesEqual(C.toNested(), simpleMultiply(matrix.getMatrixA(), matrix.getMatrixB())));
+    }
+    AlignedMatrix<int> C(5, 5);
+    assert(!multiplyFixedDispatch(5, C.data(), C.ld(), C.data(), C.ld(), C.data(), C.ld()));
+}
+
+/**
+ * @brief Тестирование разреженных операндов
+ *
+ * Проверка CSR/CSC-представлений, совпадения всех путей multiplySparse с multiplyLinear
+ * на прямоугольных матрицах и выбора пути по измеренной плотности
+ */
+void MatrixTest::testSparse() {
+    std::cout << "Проверка разреженных операндов" << std::endl;
+    Matrix matrix(70, 90, 130);
+    matrix.initialize(11, 0.05, 0.03);
+    const CsrMatrix csr = CsrMatrix::fromDense(matrix.viewA(), 3);
+    const CscMatrix csc = CscMatrix::fromDense(matrix.viewB(), 3);
+    assert(csr.rows == 70 && csr.cols == 130 && csc.rows == 130 && csc.cols == 90);
+    assert(csr.nnz() == static_cast<std::size_t>(std::lround(density(matrix.viewA(), 2) * 70 * 130)));
+    assert(csc.nnz() == static_cast<std::size_t>(std::lround(density(matrix.viewB(), 2) * 130 * 90)));
+    assert(csr.nnz() > 0 && csr.nnz() < 70 * 130 / 10);
+
+    matrix.multiplyLinear();
+    const auto expected = matrix.getMatrixC();
+    const std::vector<SparsePath> paths = { SparsePath::Dense, SparsePath::SparseA, SparsePath::SparseB,
+        SparsePath::SparseAB };
+    for (SparsePath path : paths) {
+        matrix.multiplySparse(3, path);
+        assert(matrix.lastSparsePath() == path);
+        assert(areMatricesEqual(matrix.getMatrixC(), expected));
+    }
+    matrix.multiplySparse(3);
+    assert(matrix.lastSparsePath() == SparsePath::SparseAB);
+
+    // Плотная A и разреженная B: Auto переводит в CSC только B, после замены B - ни одного
+    matrix.initialize(12, 1.0, 0.02);
+    matrix.multiplyLinear();
+    const auto expectedB = matrix.getMatrixC();
+    matrix.multiplySparse(2);
+    assert(matrix.lastSparsePath() == SparsePath::SparseB);
+    assert(areMatricesEqual(matrix.getMatrixC(), expectedB));
+    matrix.initialize(13);
+    matrix.multiplySparse(2);
+    assert(matrix.lastSparsePath() == SparsePath::Dense);
+
+    // Внешний B, изменённый между умножениями: плотности и CSR/CSC-копии строятся заново
+    for (SparsePath path : { SparsePath::Auto, SparsePath::SparseB, SparsePath::SparseAB }) {
+        std::vector<int> external(4 * 4, 0);
+        external[0] = 5;
+        Matrix adopted(4);
+        adopted.setMatrixA({ {1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1} });
+        adopted.adoptMatrixB(external.data(), 4, 4, 4);
+        adopted.multiplySparse(1, path);
+        assert(adopted.getMatrixC()[0][0] == 5);
+        external[0] = 15;
+        adopted.multiplySparse(1, path);
+        assert(adopted.getMatrixC()[0][0] == 15);
+    }
+
+    assert(chooseSparsePath(0.5, 0.01, SPARSE_DENSITY_THRESHOLD) == SparsePath::SparseB);
+    assert(chooseSparsePath(0.01, 0.5, SPARSE_DENSITY_THRESHOLD) == SparsePath::SparseA);
+    assert(chooseSparsePath(0.5, 0.5, SPARSE_DENSITY_THRESHOLD) == SparsePath::Dense);
+}
+
+/**
+ * @brief Тестирование умножения матриц из файлов
+ *
+ * Проверка записи и чтения файла матрицы, потокового умножения с бюджетом памяти на несколько
+ * панелей против multiplyLinear и отказа от файлов с неверным заголовком или размерами
+ */
+void MatrixTest::testOutOfCore() {
+    std::cout << "Проверка умножения матриц из файлов" << std::endl;
+    const std::string pathA = "matrix_test_A.bin", pathB = "matrix_test_B.bin", pathC = "matrix_test_C.bin";
+    Matrix matrix(70, 90, 130);
+    matrix.initialize(21);
+    matrix.multiplyLinear();
+    writeMatrixFile(pathA, matrix.viewA());
+    writeMatrixFile(pathB, matrix.viewB());
+
+    {
+        const MappedMatrix A = MappedMatrix::open(pathA);
+        const MappedMatrix B = MappedMatrix::open(pathB);
+        assert(A.rows() == 70 && A.cols() == 130 && B.rows() == 130 && B.cols() == 90 && !A.writable());
+        assert(reinterpret_cast<std::uintptr_t>(A.data()) % MATRIX_ALIGNMENT == 0);
+
+        // Бюджет на панели по 16 строк C и панели B по 32 строки
+        OutOfCoreOptions options;
+        options.tiles = BlockSizes{ 16, 64, 32 };
+        options.memoryBudget = (16 * (130 + 90) + 2 * 32 * 90) * sizeof(int);
+        options.num_threads = 3;
+        MappedMatrix C = MappedMatrix::create(pathC, 70, 90);
+        multiplyOutOfCore(A, B, C, options);
+        assert(areMatricesEqual(AlignedMatrix<int>::adopt(C.mutableData(), 70, 90, C.ld()).toNested(),
+            matrix.getMatrixC()));
+
+        assert(expectThrows<std::invalid_argument>([&] { multiplyOutOfCore(A, A, C); }));
+    }
+
+    {
+        const MappedMatrix C = MappedMatrix::open(pathC);
+        AlignedMatrix<int> copy(C.rows(), C.cols());
+        for (int i = 0; i < C.rows(); i++) {
+            std::copy(C.view().row(i), C.view().row(i) + C.cols(), copy.row(i));
+        }
+        assert(areMatricesEqual(copy.toNested(), matrix.getMatrixC()));
+    }
+
+    // Файл, обрезанный посередине данных, и файл с чужим заголовком не открываются
+    std::vector<char> bytes;
+    {
+        std::ifstream in(pathB, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    // Заголовок с шагом строки, при котором rows * ld * 4 переполняется до размера файла
+    std::vector<char> overflow = bytes;
+    MatrixFileHeader header;
+    std::memcpy(&header, overflow.data(), sizeof(header));
+    header.rows = std::int64_t(1) << 30;
+    header.ld = std::int64_t(1) << 32;
+    std::memcpy(overflow.data(), &header, sizeof(header));
+    const std::vector<std::vector<char>> broken = {
+        std::vector<char>(bytes.begin(), bytes.begin() + bytes.size() / 2),
+        std::vector<char>(bytes.size(), 'x'), overflow };
+    for (const auto& content : broken) {
+        std::ofstream(pathC, std::ios::binary | std::ios::trunc).write(content.data(), content.size());
+        assert(expectThrows<std::runtime_error>([&] { MappedMatrix::open(pathC); }));
+    }
+
+    std::remove(pathA.c_str());
+    std::remove(pathB.c_str());
+    std::remove(pathC.c_str());
+}
+
+/**
+ * @brief Тестирование пула потоков
+ *
+ * Проверка покрытия плиток, ограничения числа участников, передачи исключения, одновременных
+ * вызовов из нескольких потоков и совпадения планировки steal с OpenMP во всех ядрах
+ */
+void MatrixTest::testThreadPool() {
+    std::cout << "Проверка пула потоков" << std::endl;
+    ThreadPool pool(4, false);
+    const int rows = 37, cols = 53;
+    std::vector<std::atomic<int>> visits(rows * cols);
+    std::vector<std::atomic<int>> usedWorkers(pool.size());
+    pool.parallelFor2D(rows, cols, 5, 7, 2, [&](int worker, int i0, int i1, int j0, int j1) {
+        usedWorkers[worker] = 1;
+        for (int i = i0; i < i1; i++) {
+            for (int j = j0; j < j1; j++) visits[i * cols + j]++;
+        }
+    });
+    int participants = 0;
+    for (const auto& used : usedWorkers) participants += used;
+    assert(participants >= 1 && participants <= 2);
+    for (const auto& count : visits) assert(count == 1);
+
+    assert(expectThrows<std::runtime_error>([&] {
+        pool.parallelFor2D(10, 10, 1, 1, 4, [](int, int i0, int, int j0, int) {
+            if (i0 == 3 && j0 == 4) throw std::runtime_error("плитка");
+        });
+    }));
+
+    // Одновременные вызовы из нескольких потоков делят общий пул
+    const int size = 96;
+    std::vector<std::thread> callers;
+    std::atomic<int> failures{ 0 };
+    for (int t = 0; t < 4; t++) {
+        callers.emplace_back([&, t] {
+            Matrix matrix(size);
+            matrix.initialize(t);
+            matrix.multiplyLinear();
+            const auto expected = matrix.getMatrixC();
+            matrix.multiplyParallel(4, WORK_STEALING_SCHEDULE);
+            if (!areMatricesEqual(matrix.getMatrixC(), expected)) failures++;
+            matrix.multiplyBlockedParallel(3, 16, 32, 24, WORK_STEALING_SCHEDULE);
+            if (!areMatricesEqual(matrix.getMatrixC(), expected)) failures++;
+        });
+    }
+    for (auto& caller : callers) caller.join();
+    assert(failures == 0);
+
+    Matrix matrix(size);
+    matrix.initialize(9);
+    matrix.multiplyParallel(3, WORK_STEALING_SCHEDULE, 5);
+    const MultiplyTelemetry& telemetry = matrix.lastTelemetry();
+    long long iterations = 0;
+    for (const auto& record : telemetry.threads) iterations += record.iterations;
+    assert(iterations == static_cast<long long>(size) * size);
+    assert(!telemetry.threads.empty() && telemetry.threads.size() <= 3);
+
+    Matrix transposed(40, 33, 50, Transpose::T, Transpose::T);
+    transposed.initialize(4);
+    transposed.gemm(2, 0, 3);
+    const auto expected = transposed.getMatrixC();
+    transposed.gemm(2, 0, 3, WORK_STEALING_SCHEDULE);
+    assert(areMatricesEqual(transposed.getMatrixC(), expected));
+
+    // beta != 0: плитки пула масштабируют свою часть C перед накоплением
+    Matrix accumulated = transposed;
+    accumulated.gemm(1, 3, 3);
+    transposed.gemm(1, 3, 3, WORK_STEALING_SCHEDULE);
+    assert(areMatricesEqual(transposed.getMatrixC(), accumulated.getMatrixC()));
+}
+
+/**
+ * @brief Тестирование асинхронной очереди умножений
+ *
+ * Проверка результатов нескольких одновременно выполняемых произведений разных размеров,
+ * конвейера с повторным использованием буферов операндов, ограничения очереди и ошибок.
+ */
+void MatrixTest::testAsyncMultiply() {
+    std::cout << "Проверка асинхронной очереди умножений" << std::endl;
+    const std::vector<int> sizes = { 33, 64, 90, 17, 128, 71 };
+    MultiplyQueue queue(2, 2, 2);
+
+    // Конвейер: следующие операнды заполняются, пока предыдущие умножаются
+    std::vector<std::future<MultiplyResult>> futures;
+    std::vector<std::vector<std::vector<int>>> expected;
+    for (std::size_t i = 0; i < sizes.size(); i++) {
+        AlignedMatrix<int> A(sizes[i], sizes[(i + 1) % sizes.size()]);
+        AlignedMatrix<int> B(A.cols(), sizes[(i + 2) % sizes.size()]);
+        fillRandom(A, 30 + i, 0, -100, 100);
+        fillRandom(B, 30 + i, 1, -100, 100);
+        expected.push_back(simpleMultiply(A.toNested(), B.toNested()));
+        futures.push_back(queue.submit(std::move(A), std::move(B)));
+    }
+    AlignedMatrix<int> reusedA, reusedB;
+    for (std::size_t i = 0; i < futures.size(); i++) {
+        MultiplyResult result = futures[i].get();
+        assert(areMatricesEqual(result.C.toNested(), expected[i]));
+        assert(result.seconds >= 0 && result.queueSeconds >= 0);
+        assert(result.A.rows() == sizes[i]);
+        if (i == 0) {
+            reusedA = std::move(result.A);
+            reusedB = std::move(result.B);
+        }
+    }
+
+    // Возвращённые буферы операндов заполняются заново без выделения памяти
+    const int* bufferA = reusedA.data();
+    fillRandom(reusedA, 40, 0, -100, 100);
+    fillRandom(reusedB, 40, 1, -100, 100);
+    const auto product = simpleMultiply(reusedA.toNested(), reusedB.toNested());
+    MultiplyResult again = queue.submit(std::move(reusedA), std::move(reusedB)).get();
+    assert(again.A.data() == bufferA);
+    assert(areMatricesEqual(again.C.toNested(), product));
+
+    assert(expectThrows<std::invalid_argument>([&] {
+        queue.submit(AlignedMatrix<int>(4, 5), AlignedMatrix<int>(6, 4));
+    }));
+
+    // Запросы, оставшиеся в очереди, выполняются до разрушения очереди
+    std::future<MultiplyResult> last;
+    {
+        MultiplyQueue shortLived(1, 1, 1);
+        for (int i = 0; i < 3; i++) {
+            last = shortLived.submit(AlignedMatrix<int>(48, 48), AlignedMatrix<int>(48, 48));
+        }
+        shortLived.wait();
+        assert(shortLived.pending() == 0);
+    }
+    assert(last.get().C.rows() == 48);
+}
+
+/**
+ * @brief Тестирование цепочек умножений и степеней
+ *
+ * Проверка оптимального порядка на известном примере, произведения цепочки с промежуточными
+ * результатами, требующими больше двух буферов, и степеней (включая нулевую) против
+ * последовательных умножений.
+ */
+void MatrixTest::testChain() {
+    std::cout << "Проверка цепочек умножений и степеней" << std::endl;
+    const ChainPlan plan = planChain({ 30, 35, 15, 5, 10, 20, 25 });
+    assert(plan.cost == 15125);
+    assert(plan.order() == "(A1(A2A3))((A4A5)A6)");
+    assert(planChain({ 10, 30, 5, 60 }).order() == "(A1A2)A3");
+    assert(planChain({ 7, 9 }).cost == 0 && planChain({ 7, 9 }).order() == "A1");
+
+    const std::vector<int> dims = { 30, 35, 15, 5, 10, 20, 25 };
+    std::vector<AlignedMatrix<int>> matrices;
+    std::vector<MatrixView<int>> chain;
+    for (std::size_t i = 0; i + 1 < dims.size(); i++) {
+        matrices.push_back(AlignedMatrix<int>::uninitialized(dims[i], dims[i + 1]));
+        fillRandom(matrices.back(), 50, i, -10, 10);
+    }
+    for (const auto& m : matrices) chain.push_back(m.view());
+    auto expected = matrices[0].toNested();
+    for (std::size_t i = 1; i < matrices.size(); i++) {
+        expected = simpleMultiply(expected, matrices[i].toNested());
+    }
+    assert(areMatricesEqual(multiplyChain(chain, 2).toNested(), expected));
+    assert(areMatricesEqual(multiplyChain({ chain[2] }, 2).toNested(), matrices[2].toNested()));
+
+    assert(expectThrows<std::invalid_argument>([&] { multiplyChain({ chain[0], chain[2] }, 2); }));
+
+    const int size = 40;
+    AlignedMatrix<int> base = AlignedMatrix<int>::uninitialized(size, size);
+    fillRandom(base, 51, 0, -1, 1);
+    auto power = std::vector<std::vector<int>>(size, std::vector<int>(size, 0));
+    for (int i = 0; i < size; i++) power[i][i] = 1;
+    for (int exponent = 0; exponent <= 11; exponent++) {
+        assert(areMatricesEqual(matrixPower(base, exponent, 2).toNested(), power));
+        power = simpleMultiply(power, base.toNested());
+    }
+}
+
+/**
+ * @brief Тестирование частичного пересчёта
+ *
+ * Проверка recompute после смеси изменений строк и столбцов, поправок ранга 1 и повторных
+ * изменений одних и тех же строк, полного пересчёта без предшествующего умножения, сохранности
+ * внешнего буфера и ошибок диапазона.
+ */
+void MatrixTest::testIncremental() {
+    std::cout << "Проверка частичного пересчёта" << std::endl;
+    const int m = 70, n = 300, k = 50;
+    Matrix matrix(m, n, k);
+    matrix.initialize(60);
+    matrix.multiplyParallel(2, "static");
+
+    auto rowsOf = [](int count, int length, int value) {
+        std::vector<std::vector<int>> rows(count, std::vector<int>(length));
+        for (int r = 0; r < count; r++) {
+            for (int j = 0; j < length; j++) rows[r][j] = (value + r * 7 + j * 3) % 19 - 9;
+        }
+        return rows;
+    };
+    std::vector<int> u(m), v(k), x(k), y(n);
+    for (int i = 0; i < m; i++) u[i] = i % 3 - 1;
+    for (int p = 0; p < k; p++) v[p] = p % 5 - 2;
+    for (int p = 0; p < k; p++) x[p] = (p * 7) % 4 - 1;
+    for (int j = 0; j < n; j++) y[j] = j % 2;
+
+    matrix.updateRowsA(5, rowsOf(3, k, 1));
+    matrix.updateRowsB(10, rowsOf(2, n, 2));
+    matrix.rankOneUpdateA(u, v);
+    matrix.updateColumnsB(20, rowsOf(3, k, 3));
+    matrix.rankOneUpdateB(x, y);
+    matrix.updateRowsA(6, rowsOf(12, k, 4));
+    matrix.updateRowsB(0, rowsOf(1, n, 5));
+    matrix.recompute(2);
+    assert(areMatricesEqual(matrix.getMatrixC(), simpleMultiply(matrix.getMatrixA(), matrix.getMatrixB())));
+
+    // Второй цикл изменений после частичного пересчёта и пересчёт без изменений
+    matrix.rankOneUpdateB(x, y);
+    matrix.updateColumnsB(n - 1, rowsOf(1, k, 6));
+    matrix.recompute(2);
+    matrix.recompute(2);
+    assert(areMatricesEqual(matrix.getMatrixC(), simpleMultiply(matrix.getMatrixA(), matrix.getMatrixB())));
+
+    // Без умножения после замены операнда пересчитывается всё
+    matrix.setMatrixA(rowsOf(m, k, 7));
+    matrix.updateRowsA(0, rowsOf(2, k, 8));
+    matrix.recompute(2);
+    assert(areMatricesEqual(matrix.getMatrixC(), simpleMultiply(matrix.getMatrixA(), matrix.getMatrixB())));
+
+    // Изменение внешнего буфера делается в собственной копии
+    const auto external = rowsOf(k, n, 9);
+    AlignedMatrix<int> buffer(k, n);
+    buffer.assign(external);
+    matrix.adoptMatrixB(buffer.data(), k, n, buffer.ld());
+    matrix.multiplyBlockedParallel(2);
+    matrix.updateRowsB(3, rowsOf(1, n, 10));
+    matrix.recompute(2);
+    assert(areMatricesEqual(buffer.toNested(), external));
+    assert(areMatricesEqual(matrix.getMatrixC(), simpleMultiply(matrix.getMatrixA(), matrix.getMatrixB())));
+
+    assert(expectThrows<std::invalid_argument>([&] { matrix.updateRowsA(m - 1, rowsOf(2, k, 0)); }));
+    assert(expectThrows<std::invalid_argument>([&] { matrix.rankOneUpdateB(u, y); }));
+}
+
+/**
+ * @brief Тестирование кэша результатов
+ *
+ * Проверка хеша (не зависит от шага строки, меняется от одного элемента), попадания при
+ * повторном умножении и в другом Matrix с тем же содержимым, промаха после изменения операнда
+ * и вытеснения при малом бюджете.
+ */
+void MatrixTest::testResultCache() {
+    std::cout << "Проверка кэша результатов" << std::endl;
+    const int m = 40, n = 70, k = 30;
+    AlignedMatrix<int> padded(m, k);
+    fillRandom(padded, 3, 0, -5, 5);
+    std::vector<int> tight(static_cast<std::size_t>(m) * k);
+    for (int i = 0; i < m; i++) std::copy(padded.row(i), padded.row(i) + k, tight.data() + i * k);
+    const MatrixHash hash = hashMatrix(padded.view(), 2);
+    assert(hash == hashMatrix(MatrixView<int>(tight.data(), m, k, k), 1));
+    tight[5 * k + 7]++;
+    assert(!(hash == hashMatrix(MatrixView<int>(tight.data(), m, k, k), 2)));
+    assert(!(hash == hashMatrix(MatrixView<int>(tight.data(), k, m, m), 2)));
+
+    auto cache = std::make_shared<ResultCache>(std::size_t(1) << 20);
+    Matrix first(m, n, k);
+    first.initialize(70);
+    first.setResultCache(cache);
+    first.multiplyParallel(2, "static");
+    assert(!first.lastCacheHit());
+    const auto expected = simpleMultiply(first.getMatrixA(), first.getMatrixB());
+    assert(areMatricesEqual(first.getMatrixC(), expected));
+    first.multiplyBlocked();
+    assert(first.lastCacheHit());
+    assert(areMatricesEqual(first.getMatrixC(), expected));
+
+    // Внешний буфер, изменённый на месте между умножениями: хеш считается заново, попадания нет
+    std::vector<int> onesA(4 * 4, 1), onesB(4 * 4, 1);
+    Matrix adopted(4);
+    adopted.setResultCache(std::make_shared<ResultCache>(std::size_t(1) << 20));
+    adopted.adoptMatrixA(onesA.data(), 4, 4, 4);
+    adopted.adoptMatrixB(onesB.data(), 4, 4, 4);
+    adopted.multiplyParallel(1, "static");
+    onesA[0] = 5;
+    adopted.multiplyParallel(1, "static");
+    assert(!adopted.lastCacheHit() && adopted.getMatrixC()[0][0] == 8);
+
+    // Другой объект с тем же содержимым операндов получает результат первого
+    Matrix second(m, n, k);
+    second.initialize(70);
+    second.setResultCache(cache);
+    second.multiplyBlockedParallel(2);
+    assert(second.lastCacheHit());
+    assert(areMatricesEqual(second.getMatrixC(), expected));
+
+    // Изменённый операнд хешируется заново; gemm с alpha != 1 кэш не использует
+    second.updateRowsA(3, { std::vector<int>(k, 1) });
+    second.multiplyParallel(2, "dynamic");
+    assert(!second.lastCacheHit());
+    assert(areMatricesEqual(second.getMatrixC(), simpleMultiply(second.getMatrixA(), second.getMatrixB())));
+    second.gemm(2, 0, 2);
+    assert(!second.lastCacheHit());
+    second.multiplyParallel(2, "dynamic");
+    assert(second.lastCacheHit());
+    second.updateRowsB(0, { std::vector<int>(n, 2) });
+    second.recompute(2);
+    assert(!second.lastCacheHit());
+    CacheStats stats = cache->stats();
+    assert(stats.hits == 3 && stats.misses == 2 && stats.entries == 2);
+    assert(stats.hashSeconds > 0 && stats.missSeconds > 0);
+
+    // Бюджет на один результат: каждый новый вытесняет предыдущий
+    auto small = std::make_shared<ResultCache>(static_cast<std::size_t>(m) * AlignedMatrix<int>::paddedLeadingDimension(n)
+        * sizeof(int));
+    Matrix third(m, n, k);
+    third.setResultCache(small);
+    for (int seed = 0; seed < 3; seed++) {
+        third.initialize(seed);
+        third.multiplyBlocked();
+    }
+    third.initialize(0);
+    third.multiplyBlocked();
+    assert(!third.lastCacheHit());
+    stats = small->stats();
+    assert(stats.evictions == 3 && stats.entries == 1 && stats.hits == 0);
+
+    third.setResultCache(nullptr);
+    third.multiplyBlocked();
+    assert(!third.lastCacheHit());
+
+    // Узкие типы и накопление с проверкой не получают результат умножения в int32 из общего кэша
+    Matrix narrowMatrix(2);
+    narrowMatrix.setResultCache(cache);
+    narrowMatrix.setMatrixA({ {1000, 0}, {0, 1} });
+    narrowMatrix.setMatrixB({ {1, 0}, {0, 1} });
+    narrowMatrix.multiplyParallel(1, "static");
+    assert(expectThrows<std::out_of_range>([&] {
+        narrowMatrix.multiplyNarrow(1, ElementType::Int8);
+    }) && !narrowMatrix.lastCacheHit());
+    narrowMatrix.multiplyNarrow(1, ElementType::Int16);
+    assert(!narrowMatrix.lastCacheHit());
+    narrowMatrix.multiplyNarrow(1, ElementType::Int16);
+    assert(narrowMatrix.lastCacheHit() && narrowMatrix.getMatrixC()[0][0] == 1000);
+
+    Matrix overflowMatrix(1, 1, 2);
+    overflowMatrix.setResultCache(cache);
+    overflowMatrix.setMatrixA({ {INT_MAX, INT_MAX} });
+    overflowMatrix.setMatrixB(std::vector<std::vector<int>>{ {1}, {1} });
+    overflowMatrix.multiplyParallel(1, "static");
+    assert(expectThrows<std::overflow_error>([&] {
+        overflowMatrix.multiplyNarrow(1, ElementType::Int32, Accumulation::Int64Checked);
+    }) && !overflowMatrix.lastCacheHit());
+}
+
+/**
+ * @brief Тестирование выражений с эпилогами
+ *
+ * Сверка evaluate, свёрток и точных сумм с поэлементным счётом по simpleMultiply на размерах,
+ * не кратных блокам, с несколькими панелями по k и транспонированными операндами; одинаковый
+ * элемент при переполнении int во всех свёртках, C = A * B + C на месте и ошибки размеров.
+ */
+void MatrixTest::testExpressions() {
+    std::cout << "Проверка выражений с эпилогами" << std::endl;
+    const int m = 45, n = 70, k = 37;
+    const BlockSizes tiles = { 16, 24, 8 };
+    AlignedMatrix<int> A(m, k), B(k, n), D(m, n), At(k, m), Bt(n, k);
+    fillRandom(A, 80, 0, -6, 6);
+    fillRandom(B, 80, 1, -6, 6);
+    fillRandom(D, 80, 2, -50, 50);
+    for (int i = 0; i < m; i++) {
+        for (int p = 0; p < k; p++) At.row(p)[i] = A.row(i)[p];
+    }
+    for (int p = 0; p < k; p++) {
+        for (int j = 0; j < n; j++) Bt.row(j)[p] = B.row(p)[j];
+    }
+    const auto C = simpleMultiply(A.toNested(), B.toNested());
+
+    // Ожидаемое значение relu(2 * A * B + D), ограниченное сверху 60
+    auto expected = [&](int i, int j) { return std::min(std::max(2 * C[i][j] + D.row(i)[j], 0), 60); };
+    const auto expression = clamp(relu(2 * product(A.view(), B.view()) + D.view()), INT_MIN, 60);
+    const auto transposed = clamp(relu(product(At.view(), Bt.view(), Transpose::T, Transpose::T) * 2 + D.view()),
+        INT_MIN, 60);
+    for (int threads : { 1, 3 }) {
+        for (const AlignedMatrix<int>& result : { evaluate(expression, threads, tiles), evaluate(transposed, threads) }) {
+            for (int i = 0; i < m; i++) {
+                for (int j = 0; j < n; j++) assert(result.row(i)[j] == expected(i, j));
+            }
+        }
+
+        std::vector<long long> rows(m, 0), cols(n, 0), pureRows(m, 0), pureCols(n, 0);
+        long long total = 0, pureTotal = 0;
+        for (int i = 0; i < m; i++) {
+            for (int j = 0; j < n; j++) {
+                rows[i] += expected(i, j);
+                cols[j] += expected(i, j);
+                total += expected(i, j);
+                pureRows[i] += C[i][j];
+                pureCols[j] += C[i][j];
+                pureTotal += C[i][j];
+            }
+        }
+        assert(rowSums(expression, threads, tiles) == rows);
+        assert(columnSums(transposed, threads, tiles) == cols);
+        assert(sum(expression, threads) == total);
+        assert(rowSums(product(A.view(), B.view()), threads, tiles) == pureRows);
+        assert(columnSums(product(At.view(), B.view(), Transpose::T), threads) == pureCols);
+        assert(exactRowSums(product(A.view(), Bt.view(), Transpose::N, Transpose::T), threads) == pureRows);
+        assert(exactColumnSums(product(At.view(), B.view(), Transpose::T), threads) == pureCols);
+        assert(exactSum(product(At.view(), Bt.view(), Transpose::T, Transpose::T), threads) == pureTotal);
+    }
+
+    // След: квадратное произведение A * A^T, с операциями и без
+    long long pureTrace = 0, reluTrace = 0;
+    for (int i = 0; i < m; i++) {
+        int value = 0;
+        for (int p = 0; p < k; p++) value += A.row(i)[p] * A.row(i)[p];
+        pureTrace += value;
+        reluTrace += std::max(value - 100, 0);
+    }
+    AlignedMatrix<int> shift(m, m);
+    for (int i = 0; i < m; i++) shift.row(i)[i] = -100;
+    assert(trace(product(A.view(), A.view(), Transpose::N, Transpose::T), 2) == pureTrace);
+    assert(trace(relu(product(A.view(), At.view()) + shift.view()), 2) == reluTrace);
+
+    // Элемент 2^20 * 2^20 переполняет int: свёртки видят тот же элемент, что evaluate, точные - 2^40
+    AlignedMatrix<int> big(1, 1);
+    big.row(0)[0] = 1 << 20;
+    const ProductExpr square = product(big.view(), big.view());
+    const int wrapped = evaluate(square, 1).row(0)[0];
+    assert(rowSums(square, 1) == std::vector<long long>({ wrapped }));
+    assert(rowSums(square * 1, 1) == rowSums(square, 1) && columnSums(square, 1) == rowSums(square, 1));
+    assert(sum(square, 1) == wrapped && trace(square, 1) == wrapped);
+    assert(exactRowSums(square, 1) == std::vector<long long>({ 1LL << 40 }) && exactSum(square, 1) == 1LL << 40);
+
+    // Масштаб и сложение тоже считаются по модулю 2^32: INT_MAX * 2 + 2 == 0
+    AlignedMatrix<int> one(1, 1), two(1, 1);
+    one.row(0)[0] = 1;
+    two.row(0)[0] = 2;
+    AlignedMatrix<int> limit(1, 1);
+    limit.row(0)[0] = INT_MAX;
+    assert(evaluate(product(limit.view(), one.view()) * 2 + two.view(), 1).row(0)[0] == 0);
+
+    // C = A * B + C на месте, пустое общее измерение
+    AlignedMatrix<int> accumulated = D;
+    evaluate(product(A.view(), B.view()) + accumulated.view(), accumulated.data(), accumulated.ld(), 2, tiles);
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) assert(accumulated.row(i)[j] == C[i][j] + D.row(i)[j]);
+    }
+    const AlignedMatrix<int> empty = evaluate(product(A.view().block(0, 0, m, 0), B.view().block(0, 0, 0, n)) + D.view(), 2);
+    assert(areMatricesEqual(empty.toNested(), D.toNested()));
+
+    // Произведение операндов Matrix
+    Matrix matrix(m, n, k);
+    matrix.initialize(81);
+    matrix.multiplyBlockedParallel(2);
+    assert(areMatricesEqual(evaluate(matrix.lazyProduct(), 2).toNested(), matrix.getMatrixC()));
+
+    assert(expectThrows<std::invalid_argument>([&] { product(A.view(), A.view()); }));
+    assert(expectThrows<std::invalid_argument>([&] { trace(product(A.view(), B.view()), 1); }));
+
+    // Число потоков проверяется во всех точках входа
+    const ProductExpr gram = product(A.view(), At.view());
+    AlignedMatrix<int> target(m, m);
+    for (int threads : { 0, -1 }) {
+        assert(expectThrows<std::invalid_argument>([&] { evaluate(gram, target.data(), target.ld(), threads); }));
+        assert(expectThrows<std::invalid_argument>([&] { evaluate(gram * 2, threads); }));
+        assert(expectThrows<std::invalid_argument>([&] { rowSums(gram, threads); }));
+        assert(expectThrows<std::invalid_argument>([&] { columnSums(gram, threads); }));
+        assert(expectThrows<std::invalid_argument>([&] { sum(gram, threads); }));
+        assert(expectThrows<std::invalid_argument>([&] { trace(gram, threads); }));
+        assert(expectThrows<std::invalid_argument>([&] { exactRowSums(gram, threads); }));
+        assert(expectThrows<std::invalid_argument>([&] { exactColumnSums(gram, threads); }));
+        assert(expectThrows<std::invalid_argument>([&] { exactSum(gram, threads); }));
+    }
+}
+
+/**
+ * @brief Тестирование проверки Фрейвалдса
+ *
+ * Проверка обнаружения искажённого элемента, транспонированных операндов и alpha, режима
+ * проверки после каждого умножения и умножения размера, для которого сверка с simpleMultiply
+ * слишком долгая.
+ */
+void MatrixTest::testVerify() {
+    std::cout << "Проверка результата методом Фрейвалдса" << std::endl;
+    const int size = 96;
+    Matrix matrix(size);
+    matrix.initialize(21);
+    matrix.multiplyParallel(2, "static");
+    assert(matrix.verify());
+    assert(matrix.verify(FREIVALDS_MAX_ROUNDS, 2, 7));
+
+    auto corrupted = matrix.getMatrixC();
+    corrupted[size / 2][size - 1] += 1;
+    matrix.setMatrixC(corrupted);
+    assert(!matrix.verify(32));
+    assert(expectThrows<std::invalid_argument>([&] { matrix.verify(0); }));
+
+    const int m = 40, n = 56, k = 24;
+    Matrix transposed(m, n, k, Transpose::T, Transpose::T);
+    transposed.initialize(22);
+    transposed.setVerification();
+    transposed.gemm(1, 0, 2);
+    assert(transposed.verify(20, 2));
+    transposed.gemm(3, 0, 2);
+    assert(!transposed.verify(20, 2));
+    assert(freivaldsCheck(Transpose::T, Transpose::T, 3, transposed.viewA(), transposed.viewB(),
+        transposed.viewC(), 20, FREIVALDS_SEED, 2));
+
+    const int large = 1536;
+    Matrix big(large);
+    big.initialize(23);
+    big.setVerification();
+    big.multiplyBlockedParallel(2);
+    big.multiplyStrassen(2);
+    assert(big.verify(FREIVALDS_ROUNDS, 2));
+}
+
+/**
+ * @brief Тестирование аппаратных счётчиков
+ *
+ * Проверка сложения показаний и IPC, сбора счётчиков по потокам параллельного умножения
+ * (если perf_event_open доступен в системе) и пустого отчёта для выключенных счётчиков и пула.
+ */
+void MatrixTest::testPerfCounters() {
+    std::cout << "Проверка аппаратных счётчиков" << std::endl;
+    PerfCounts first;
+    first.cycles = 100;
+    first.instructions = 250;
+    PerfCounts second;
+    second.cycles = 300;
+    second.l1dMisses = 7;
+    first += second;
+    assert(first.cycles == 400 && first.instructions == 250 && first.l1dMisses == 7 && first.llcMisses == -1);
+    assert(first.ipc() > 0.62 && first.ipc() < 0.63);
+    assert(!PerfCounts().available() && PerfCounts().ipc() == 0);
+
+    const int size = 64;
+    Matrix matrix(size);
+    matrix.initialize(3);
+    matrix.multiplyParallel(2, "static");
+    assert(matrix.lastPerfCounters().threads.empty());
+
+    matrix.enablePerfCounters();
+    matrix.multiplyParallel(2, "static");
+    const PerfReport& report = matrix.lastPerfCounters();
+    assert(report.threads.size() == 2);
+    if (perfCountersAvailable()) {
+        const PerfCounts total = report.total();
+        assert(total.available());
+        assert(total.cycles != 0 && total.instructions != 0);
+    }
+    else {
+        std::cout << "perf_event_open недоступен, проверяется только структура отчёта" << std::endl;
+    }
+    matrix.multiplyLinear();
+    assert(matrix.lastPerfCounters().threads.size() == 1);
+    matrix.multiplyParallel(2, WORK_STEALING_SCHEDULE);
+    assert(matrix.lastPerfCounters().threads.empty());
+}
+
+/**
+ * @brief Тестирование закрепления потоков
+ *
+ * Проверка разбора правил, планов закрепления по топологии, ядер и узлов в телеметрии
+ * и корректности умножения с размещением страниц по узлам NUMA. Закрепление потоков OpenMP
+ * сохраняется после теста, поэтому он выполняется последним.
+ */
+void MatrixTest::testAffinity() {
+    std::cout << "Проверка закрепления потоков" << std::endl;
+    const NumaTopology& topology = NumaTopology::system();
+    assert(topology.nodes() >= 1);
+    for (int node = 0; node < topology.nodes(); node++) {
+        assert(!topology.nodeCpus[node].empty());
+        assert(topology.nodeOf(topology.nodeCpus[node].front()) == topology.nodeIds[node]);
+    }
+    const int firstCpu = topology.nodeCpus[0].front();
+
+    assert(parseAffinity("compact").policy == AffinityPolicy::Compact);
+    assert(parseAffinity("spread").policy == AffinityPolicy::Spread);
+    assert(parseAffinity("none").policy == AffinityPolicy::None);
+    const AffinityConfig list = parseAffinity("3,1");
+    assert(list.policy == AffinityPolicy::Explicit && list.cpus == std::vector<int>({ 3, 1 }));
+    assert(affinityName(list) == "3,1" && affinityName(parseAffinity("spread")) == "spread");
+    assert(expectThrows<std::invalid_argument>([&] { parseAffinity("everywhere"); }));
+
+    const std::vector<AffinityPolicy> policies = { AffinityPolicy::Compact, AffinityPolicy::Spread };
+    for (AffinityPolicy policy : policies) {
+        AffinityConfig config;
+        config.policy = policy;
+        const std::vector<int> plan = affinityPlan(config, 5);
+        assert(plan.size() == 5);
+        for (int cpu : plan) assert(topology.nodeOf(cpu) >= 0);
+    }
+    assert(affinityPlan(AffinityConfig(), 4).empty());
+
+    const int size = 64;
+    Matrix matrix(size);
+    matrix.initialize(5);
+    matrix.multiplyLinear();
+    const auto expected = matrix.getMatrixC();
+
+    AffinityConfig pinned;
+    pinned.policy = AffinityPolicy::Explicit;
+    pinned.cpus = { firstCpu };
+    pinned.numaPlacement = true;
+    matrix.setAffinity(pinned);
+    const std::vector<int> callerCpus = currentThreadCpus();
+    matrix.multiplyParallel(2, "static");
+    assert(areMatricesEqual(matrix.getMatrixC(), expected));
+    for (const auto& record : matrix.lastTelemetry().threads) {
+        assert(record.cpu == firstCpu && record.node == topology.nodeOf(firstCpu));
+    }
+    matrix.multiplyBlockedParallel(2);
+    assert(areMatricesEqual(matrix.getMatrixC(), expected));
+    // Вызывающий поток (поток 0 команды) после умножения снова может выполняться на прежних ядрах
+    assert(currentThreadCpus() == callerCpus);
+
+    AffinityConfig unavailable;
+    unavailable.policy = AffinityPolicy::Explicit;
+    unavailable.cpus = { 1 << 20 };
+    assert(expectThrows<std::invalid_argument>([&] {
+        matrix.setAffinity(unavailable);
+    }) && matrix.affinity().cpus == pinned.cpus);
+}
+
 // Вспомогательные методы
 
 bool MatrixTest::areMatricesEqual(const std::vector<std::vector<int>>& matrix1,
@@ -288,11 +1697,13 @@ bool MatrixTest::areMatricesEqual(const std::vector<std::vector<int>>& matrix1,
 
 std::vector<std::vector<int>> MatrixTest::simpleMultiply(const std::vector<std::vector<int>>& A,
     const std::vector<std::vector<int>>& B) {
-    int n = A.size();
-    std::vector<std::vector<int>> result(n, std::vector<int>(n, 0));
-    for (int i = 0; i < n; i++) {
+    const int m = static_cast<int>(A.size());
+    const int inner = static_cast<int>(B.size());
+    const int n = inner == 0 ? 0 : static_cast<int>(B[0].size());
+    std::vector<std::vector<int>> result(m, std::vector<int>(n, 0));
+    for (int i = 0; i < m; i++) {
         for (int j = 0; j < n; j++) {
-            for (int k = 0; k < n; k++) {
+            for (int k = 0; k < inner; k++) {
                 result[i][j] += A[i][k] * B[k][j];
             }
         }
@@ -56,6 +56,81 @@ public:
     /// @brief Тест на отсутствие состояний гонки
     static void testRaceCondition();
 
+    /// @brief Тест непрерывного выровненного хранилища и представлений матриц
+    static void testContiguousStorage();
+
+    /// @brief Тест блочного умножения с разными размерами блоков
+    static void testBlockedMultiply();
+
+    /// @brief Тест проверки аргументов параллельного умножения
+    static void testInvalidSchedule();
+
+    /// @brief Тест всех поддерживаемых процессором SIMD-микроядер
+    static void testMicroKernels();
+
+    /// @brief Тест умножения по Штрассену-Винограду на размерах, не равных степени двойки
+    static void testStrassen();
+
+    /// @brief Тест узких типов хранения и накопления с проверкой переполнения
+    static void testNarrowTypes();
+
+    /// @brief Тест статистики и разбора аргументов бенчмарка
+    static void testBenchmarkHarness();
+
+    /// @brief Тест телеметрии по потокам параллельного умножения
+    static void testTelemetry();
+
+    /// @brief Тест автонастройки и кэша настроек
+    static void testAutoTuner();
+
+    /// @brief Тест воспроизводимой параллельной инициализации
+    static void testSeededInitialization();
+
+    /// @brief Тест сеттеров без копирования и ленивого выделения памяти
+    static void testZeroCopySetters();
+
+    /// @brief Тест GEMM с прямоугольными и транспонированными операндами
+    static void testGemm();
+
+    /// @brief Тест пакетного умножения небольших матриц
+    static void testBatched();
+
+    /// @brief Тест ядер фиксированного размера
+    static void testFixedMatrix();
+
+    /// @brief Тест разреженных операндов и выбора пути по плотности
+    static void testSparse();
+
+    /// @brief Тест умножения матриц из файлов, отображённых в память
+    static void testOutOfCore();
+
+    /// @brief Тест пула потоков с перехватом работы
+    static void testThreadPool();
+
+    /// @brief Тест асинхронной очереди умножений
+    static void testAsyncMultiply();
+
+    /// @brief Тест цепочек умножений и степеней матрицы
+    static void testChain();
+
+    /// @brief Тест частичного пересчёта C после изменений A и B
+    static void testIncremental();
+
+    /// @brief Тест кэша результатов по содержимому операндов
+    static void testResultCache();
+
+    /// @brief Тест выражений с эпилогами, слитыми с умножением
+    static void testExpressions();
+
+    /// @brief Тест вероятностной проверки результата (Фрейвалдс)
+    static void testVerify();
+
+    /// @brief Тест аппаратных счётчиков производительности
+    static void testPerfCounters();
+
+    /// @brief Тест закрепления потоков и топологии NUMA
+    static void testAffinity();
+
 private:
     /**
      * @brief Сравнение двух матриц на равенство
@@ -75,6 +150,21 @@ private:
     static std::vector<std::vector<int>> simpleMultiply(const std::vector<std::vector<int>>& A,
         const std::vector<std::vector<int>>& B);
 
+    /**
+     * @brief Проверка, что вызов f выбрасывает исключение типа E
+     * @return true, если было выброшено E
+     */
+    template <class E, class F>
+    static bool expectThrows(F&& f) {
+        try {
+            f();
+        }
+        catch (const E&) {
+            return true;
+        }
+        return false;
+    }
+
     /**
      * @brief Валидация ускорения многопоточной версии
      * @param singleThreadTime Время однопоточного выполнения